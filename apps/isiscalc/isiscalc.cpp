@@ -1,49 +1,157 @@
 #include <DataStorage/io_application.hpp>
 #include <DataStorage/io_factory.hpp>
+#include <DataStorage/numeric_convert.hpp>
+#include <CoreUtils/threadpool.hpp>
 #include <muParser.h>
 
 
 using namespace isis;
 
-class VoxelOp : public data::VoxelOp<double>
+/**
+ * Evaluates the expression for whole blocks of voxels using the bulk mode of muParser.
+ * The expression is parsed once into muParsers bytecode, which then is run for all voxels of a block.
+ * The voxels are computed in their own type, so there is no need to convert the image to double.
+ */
+class BulkEvaluator
 {
+	static const size_t bulk_size = 1024;
+	std::string expr;
 	mu::Parser parser;
-	double voxBuff;
-	util::FixedVector<double, 4> posBuff;
-public:
-	VoxelOp( std::string expr ) {
+	std::vector<double> voxBuff, resultBuff;
+	std::vector<double> posBuff[4];
+	bool usesPos[4];
+	void init() {
+		voxBuff.resize( bulk_size );
+		resultBuff.resize( bulk_size );
 		parser.SetExpr( expr );
-		parser.DefineVar( std::string( "vox" ), &voxBuff );
-		parser.DefineVar( std::string( "pos_x" ), &posBuff[data::rowDim] );
-		parser.DefineVar( std::string( "pos_y" ), &posBuff[data::columnDim] );
-		parser.DefineVar( std::string( "pos_z" ), &posBuff[data::sliceDim] );
-		parser.DefineVar( std::string( "pos_t" ), &posBuff[data::timeDim] );
+		parser.DefineVar( std::string( "vox" ), &voxBuff[0] );
+
+		const char *posNames[] = {"pos_x", "pos_y", "pos_z", "pos_t"};
+
+		for( int d = 0; d < 4; d++ ) {
+			posBuff[d].resize( bulk_size );
+			parser.DefineVar( posNames[d], &posBuff[d][0] );
+		}
 	}
-	bool operator()( double &vox, const isis::util::vector4<size_t>& pos ) {
-		voxBuff = vox; //using parser.DefineVar every time would slow down the evaluation
-		posBuff = pos;
-		vox = parser.Eval();
-		return true;
+public:
+	BulkEvaluator( std::string _expr ): expr( _expr ) {
+		init();
+		const mu::varmap_type used = parser.GetUsedVar(); // this parses the expression, so errors are thrown here
+		const char *posNames[] = {"pos_x", "pos_y", "pos_z", "pos_t"};
+
+		for( int d = 0; d < 4; d++ )
+			usesPos[d] = used.find( posNames[d] ) != used.end();
 	}
+	// the variables of the parser point into the object, so a copy needs its own parser and buffers
+	BulkEvaluator( const BulkEvaluator &ref ): expr( ref.expr ) {
+		init();
+		std::copy( ref.usesPos, ref.usesPos + 4, usesPos );
+	}
+	/**
+	 * Compute the expression for the voxels [start,end) of a chunk and store the results in place.
+	 * \param ch the chunk to work on (must be of type T)
+	 * \param chunkPos the position of the chunk in the image (is added to the positions of the voxels)
+	 */
+	template<typename T> void run( data::Chunk &ch, const util::vector4<size_t> &chunkPos, size_t start, size_t end ) {
+		T *data = &ch.asValueArray<T>()[0];
+		const util::vector4<size_t> size = ch.getSizeAsVector();
+		size_t idx[4];
+		ch.getCoordsFromLinIndex( start, idx );
+
+		for( size_t block = start; block < end; block += bulk_size ) {
+			const size_t n = std::min( bulk_size, end - block );
+			data::numeric_convert( data + block, &voxBuff[0], n, 1, 0 );
 
+			for( size_t i = 0; i < n; i++ ) {
+				for( int d = 0; d < 4; d++ )
+					if( usesPos[d] )
+						posBuff[d][i] = idx[d] + chunkPos[d];
+
+				for( int d = 0; d < 4 && ++idx[d] == size[d]; d++ ) // move on to the next voxel
+					idx[d] = 0;
+			}
+
+			parser.Eval( &resultBuff[0], static_cast<int>( n ) );
+			data::numeric_convert( &resultBuff[0], data + block, n, 1, 0 ); // rounds and saturates if T is an integer
+		}
+	}
 };
 
+template<typename T> void computeBlock( const BulkEvaluator &proto, data::Chunk ch, util::vector4<size_t> chunkPos, size_t start, size_t end )
+{
+	BulkEvaluator eval( proto );
+	eval.run<T>( ch, chunkPos, start, end );
+}
+
+util::ThreadPool::job makeJob( const BulkEvaluator &proto, const data::Chunk &ch, const util::vector4<size_t> &chunkPos, size_t start, size_t end )
+{
+	switch( ch.getTypeID() ) {
+#define CASE_TYPE(T) case data::ValueArray<T>::staticID: return boost::bind( computeBlock<T>, boost::cref( proto ), ch, chunkPos, start, end );
+		CASE_TYPE( int8_t ) CASE_TYPE( uint8_t ) CASE_TYPE( int16_t ) CASE_TYPE( uint16_t ) CASE_TYPE( int32_t ) CASE_TYPE( uint32_t )
+		CASE_TYPE( int64_t ) CASE_TYPE( uint64_t ) CASE_TYPE( float ) CASE_TYPE( double )
+#undef CASE_TYPE
+	default:
+		return util::ThreadPool::job();
+	}
+}
+
+/**
+ * Compute the expression for every voxel of the image.
+ * The chunks are split into blocks, which are computed in parallel.
+ * Images which are not made of scalar numbers are converted to double first.
+ * \returns false if that conversion failed
+ */
+bool compute( data::Image &img, const BulkEvaluator &proto )
+{
+	util::ThreadPool &pool = util::ThreadPool::global();
+	std::vector<data::Chunk> chunks = img.copyChunksToVector( false );
+	std::vector<util::ThreadPool::job> jobs;
+
+	for( size_t i = 0; i < chunks.size(); i++ ) {
+		const size_t volume = chunks[i].getVolume(), blocks = pool.getBlocks( volume, 1 << 16 );
+		size_t chunkPos[4];
+		img.getCoordsFromLinIndex( i * volume, chunkPos ); // chunks of an image are all of the same size
+
+		for( size_t b = 0; b < blocks; b++ ) {
+			const util::ThreadPool::job job = makeJob( proto, chunks[i], util::vector4<size_t>( chunkPos ), volume * b / blocks, volume * ( b + 1 ) / blocks );
+
+			if( job.empty() ) { // not a scalar type, so fall back to double
+				if( !img.convertToType( data::ValueArray<double>::staticID ) ) {
+					std::cerr << "Cannot compute on an image of type " << img.getMajorTypeName() << std::endl;
+					return false;
+				}
+
+				return compute( img, proto );
+			}
+
+			jobs.push_back( job );
+		}
+	}
+
+	pool.run( jobs );
+	return true;
+}
+
 int main( int argc, char **argv )
 {
 	data::IOApplication app( "isis calc", true, true );
 	app.parameters["voxelop"] = std::string( "vox" );
-	app.parameters["voxelop"].setDescription( "a term to evaluate the new value of each voxel. Available variables are: vox,pos_x,pos_y,pos_z,pos_t." );
+	app.parameters["voxelop"].setDescription(
+		"a term to evaluate the new value of each voxel. Available variables are: vox,pos_x,pos_y,pos_z,pos_t. "
+		"The result is stored in the type of the voxel (rounded and clamped for integers)." );
 	app.init( argc, argv, true ); // will exit if there is a problem
 
 
 	const std::string op = app.parameters["voxelop"];
 
 	try {
-		VoxelOp vop( op );
+		const BulkEvaluator eval( op );
 
 		BOOST_FOREACH( data::Image & img, app.images ) {
 			std::cout << "Computing vox=(" << op << ") for each voxel of the " << img.getSizeAsString() << "-Image" << std::endl;
-			img.foreachVoxel<double>( vop );
+
+			if( !compute( img, eval ) )
+				exit( -1 );
 		}
 	} catch( mu::Parser::exception_type &e ) {
 		std::cerr << e.GetMsg() << std::endl;
@@ -43,6 +43,11 @@ Application::Application( const char name[] ): m_name( name )
 	parameters["help"] = false;
 	parameters["help"].setDescription( "Print help" );
 	parameters["help"].needed() = false;
+
+	parameters["dasync"] = false;
+	parameters["dasync"].needed() = false;
+	parameters["dasync"].setDescription( "Format and write the log messages of all -d<module> log levels in a background thread, errors are still written immediately" );
+	parameters["dasync"].hidden() = true;
 }
 Application::~Application() {}
 
@@ -170,6 +175,9 @@ void Application::printHelp( bool withHidden )const
 
 boost::shared_ptr< MessageHandlerBase > Application::getLogHandler( std::string /*module*/, isis::LogLevel level )const
 {
+	if( level && parameters["dasync"] )
+		return boost::shared_ptr< MessageHandlerBase >( new util::AsyncMsgPrint( level ) );
+
 	return boost::shared_ptr< MessageHandlerBase >( level ? new util::DefaultMsgPrint( level ) : 0 );
 }
 const std::string Application::getCoreVersion( void )
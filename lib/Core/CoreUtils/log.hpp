@@ -31,23 +31,30 @@ template<class MODULE> class Log
 {
 	friend class util::Singletons;
 	boost::shared_ptr<MessageHandlerBase> m_handle;
+	// level of the current handler (0 if there is none), so the macros can drop messages before they are created
+	static LogLevel s_level;
 	static boost::shared_ptr<MessageHandlerBase> &getHandle() {
 		boost::shared_ptr<util::MessageHandlerBase> &handle = Singletons::get < Log<MODULE>, INT_MAX - 1 > ().m_handle;
 		return handle;
 	}
-	Log(): m_handle( new DefaultMsgPrint( notice ) ) {}
+	Log(): m_handle( new DefaultMsgPrint( notice ) ) {s_level = notice;}
 public:
 	template<class HANDLE_CLASS> static void enable( LogLevel enable ) {
 		setHandler( boost::shared_ptr<MessageHandlerBase>( enable ? new HANDLE_CLASS( enable ) : 0 ) );
 	}
 	static void setHandler( boost::shared_ptr<MessageHandlerBase> handler ) {
 		getHandle() = handler;
+		s_level = handler ? handler->m_level : static_cast<LogLevel>( 0 );
+	}
+	static bool enabled( LogLevel level ) {
+		return s_level >= level;
 	}
 	static Message send( const char file[], const char object[], int line, LogLevel level ) {
 		boost::shared_ptr<util::MessageHandlerBase> &handle = getHandle();
 		return Message( object, MODULE::name(), file, line, level, handle );
 	}
 };
+template<class MODULE> LogLevel Log<MODULE>::s_level = notice;
 
 }
 }
@@ -57,10 +64,11 @@ public:
 #define ENABLE_LOG(MODULE,HANDLE_CLASS,set)\
 	if(!MODULE::use);else isis::util::_internal::Log<MODULE>::enable<HANDLE_CLASS>(set)
 
+// the level is checked first, so neither the message nor the streamed arguments (nor PRED) are evaluated if the message would be dropped anyway
 #define LOG(MODULE,LEVEL)\
-	if(!MODULE::use);else isis::util::_internal::Log<MODULE>::send(__FILE__,__FUNCTION__,__LINE__,LEVEL)
+	if(!(MODULE::use && isis::util::_internal::Log<MODULE>::enabled(LEVEL)));else isis::util::_internal::Log<MODULE>::send(__FILE__,__FUNCTION__,__LINE__,LEVEL)
 
 #define LOG_IF(PRED,MODULE,LEVEL)\
-	if(!(MODULE::use && (PRED)));else isis::util::_internal::Log<MODULE>::send(__FILE__,__FUNCTION__,__LINE__,LEVEL)
+	if(!(MODULE::use && isis::util::_internal::Log<MODULE>::enabled(LEVEL) && (PRED)));else isis::util::_internal::Log<MODULE>::send(__FILE__,__FUNCTION__,__LINE__,LEVEL)
 
 #endif
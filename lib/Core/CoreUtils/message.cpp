@@ -15,6 +15,12 @@
 #include <sys/types.h>
 
 #include <boost/date_time/posix_time/posix_time.hpp> //we need the to_string functions for the automatic conversion
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/bind.hpp>
 
 #ifndef WIN32
 #include <signal.h>
@@ -30,6 +36,12 @@ struct IsEqualMsg {
 	std::string newMsg;
 	bool operator()( const std::pair<boost::posix_time::ptime, std::string>& ms ) {return ms.second == newMsg;}
 };
+boost::recursive_mutex &commitMutex()
+{
+	// never deleted, so messages can still be sent while the other statics are destroyed
+	static boost::recursive_mutex *mutex = new boost::recursive_mutex;
+	return *mutex;
+}
 }
 const char *logLevelName( LogLevel level )
 {
@@ -62,6 +74,16 @@ void MessageHandlerBase::stopBelow( LogLevel stop )
 	m_stop_below = stop;
 }
 
+void MessageHandlerBase::commitLocked( const Message &msg )
+{
+	if( isThreadSafe() ) {
+		commit( msg );
+	} else {
+		boost::lock_guard<boost::recursive_mutex> lock( _internal::commitMutex() );
+		commit( msg );
+	}
+}
+
 bool MessageHandlerBase::requestStop( LogLevel _level )
 {
 	if ( m_stop_below > _level ) {
@@ -103,11 +125,13 @@ Message::Message( const Message &src ) //we need a custom copy-constructor, beca
 
 Message::~Message()
 {
-	if ( shouldCommit() ) {
-		commitTo.lock()->commit( *this );
+	const boost::shared_ptr<MessageHandlerBase> handler( commitTo.lock() );
+
+	if ( handler && shouldCommit() ) {
+		handler->commitLocked( *this );
 		str( "" );
 		clear();
-		commitTo.lock()->requestStop( m_level );
+		handler->requestStop( m_level );
 	}
 }
 
@@ -146,6 +170,11 @@ LogLevel MessageHandlerBase::m_stop_below = error;
 
 std::ostream *DefaultMsgPrint::o = &::std::cerr;
 void DefaultMsgPrint::commit( const Message &mesg )
+{
+	print( mesg, *o );
+}
+
+void DefaultMsgPrint::print( const Message &mesg, std::ostream &out )
 {
 	//first remove everything which is to old anyway
 	std::list< std::pair<boost::posix_time::ptime, std::string> >::iterator begin = last.begin();
@@ -161,14 +190,14 @@ void DefaultMsgPrint::commit( const Message &mesg )
 	begin = std::find_if( last.begin(), last.end(), isEqual );
 
 	if( begin == last.end() ) { // its not in the list of the last xxx milliseconds - so print it
-		*o << mesg.m_module << ":" << logLevelName( mesg.m_level );
+		out << mesg.m_module << ":" << logLevelName( mesg.m_level );
 #ifndef NDEBUG //if with debug-info
-		*o << "[" << mesg.m_file.leaf() << ":" << mesg.m_line << "] "; //print the file and the line
+		out << "[" << mesg.m_file.leaf() << ":" << mesg.m_line << "] "; //print the file and the line
 #else
-		*o << "[" << mesg.m_object << "] "; //print the object/method
+		out << "[" << mesg.m_object << "] "; //print the object/method
 #endif //NDEBUG
-		*o << mesg.merge(); //print the message itself
-		*o << std::endl;
+		out << mesg.merge(); //print the message itself
+		out << std::endl;
 	} else {
 		last.erase( begin ); // it was in the list - remove it
 	}
@@ -178,9 +207,118 @@ void DefaultMsgPrint::commit( const Message &mesg )
 
 void DefaultMsgPrint::setStream( ::std::ostream &_o )
 {
+	boost::lock_guard<boost::recursive_mutex> lock( _internal::commitMutex() ); // the AsyncMsgPrint writer might be using it
 	o->flush();
 	o = &_o;
 }
 
+namespace _internal
+{
+/*
+ * The writer behind all AsyncMsgPrint handlers.
+ * Each pass of its thread formats and prints everything in the queue at once, then it sleeps a bit to collect the next batch.
+ * A pass which started after a message was queued will print it, so flush() waits for the end of the next pass to start.
+ */
+class AsyncWriter: public DefaultMsgPrint
+{
+	boost::lockfree::queue<Message *> m_queue;
+	size_t m_started, m_finished, m_requested;
+	bool m_stop;
+	boost::mutex m_mutex;
+	boost::condition_variable m_wake, m_done;
+	boost::thread m_thread;
+
+	void run() {
+		boost::unique_lock<boost::mutex> lock( m_mutex );
+
+		while( true ) {
+			const size_t pass = ++m_started;
+			lock.unlock();
+
+			std::ostringstream batch;
+			size_t count = 0;
+			Message *msg;
+
+			while( m_queue.pop( msg ) ) {
+				print( *msg, batch );
+				msg->str( "" ); // so its destructor won't commit it again
+				delete msg;
+				count++;
+			}
+
+			if( count ) { // the synchronous handlers write to the same stream under the common lock
+				boost::lock_guard<boost::recursive_mutex> lock( commitMutex() );
+				*o << batch.str() << std::flush;
+			}
+
+			lock.lock();
+			m_finished = pass;
+			m_done.notify_all();
+
+			if( m_stop ) {
+				if( !count ) // nothing was left
+					return;
+			} else if( m_requested <= m_finished ) {
+				m_wake.timed_wait( lock, boost::posix_time::milliseconds( 50 ) );
+			}
+		}
+	}
+public:
+	AsyncWriter():
+		DefaultMsgPrint( verbose_info ), m_queue( 128 ), m_started( 0 ), m_finished( 0 ), m_requested( 0 ), m_stop( false ),
+		m_thread( boost::bind( &AsyncWriter::run, this ) ) {}
+	~AsyncWriter() {
+		{
+			boost::lock_guard<boost::mutex> lock( m_mutex );
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		m_thread.join();
+	}
+	void push( const Message &msg ) {
+		m_queue.push( new Message( msg ) );
+	}
+	void flush() {
+		boost::unique_lock<boost::mutex> lock( m_mutex );
+		const size_t target = m_started + 1;
+		m_requested = std::max( m_requested, target );
+		m_wake.notify_all();
+
+		while( m_finished < target )
+			m_done.wait( lock );
+	}
+};
+
+boost::shared_ptr<AsyncWriter> getAsyncWriter()
+{
+	static boost::mutex mutex;
+	static boost::weak_ptr<AsyncWriter> shared;
+	boost::lock_guard<boost::mutex> lock( mutex );
+	boost::shared_ptr<AsyncWriter> ret = shared.lock();
+
+	if( !ret ) {
+		ret.reset( new AsyncWriter );
+		shared = ret;
+	}
+
+	return ret;
+}
+}
+
+AsyncMsgPrint::AsyncMsgPrint( LogLevel level ): MessageHandlerBase( level ), m_writer( _internal::getAsyncWriter() ) {}
+
+void AsyncMsgPrint::commit( const Message &mesg )
+{
+	m_writer->push( mesg );
+
+	if( mesg.m_level == error ) // errors are important and might be followed by a crash, so make sure they are out
+		m_writer->flush();
+}
+
+void AsyncMsgPrint::flush()
+{
+	m_writer->flush();
+}
+
 }
 }
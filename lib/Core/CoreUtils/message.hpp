@@ -21,6 +21,7 @@
 #define BOOST_FILESYSTEM_VERSION 3 
 #include <boost/filesystem/path.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 
 namespace isis
@@ -52,7 +53,12 @@ protected:
 	virtual ~MessageHandlerBase() {}
 public:
 	LogLevel m_level;
+	/// Output the message (implementations don't need to be thread-safe, the calls are serialized by commitLocked).
 	virtual void commit( const Message &msg ) = 0;
+	/// Call commit while holding the lock shared by all handlers, so messages from different threads don't interfere.
+	void commitLocked( const Message &msg );
+	/// Handlers which can deal with concurrent calls of commit themselves return true, commitLocked won't lock for them.
+	virtual bool isThreadSafe()const {return false;}
 	static void stopBelow( LogLevel );
 	bool requestStop( LogLevel _level );
 };
@@ -96,6 +102,8 @@ protected:
 	static std::ostream *o;
 	static const int max_age = 500;
 	std::list<std::pair<boost::posix_time::ptime, std::string> > last;
+	/// print the message into out, unless the same message was printed within the last max_age milliseconds
+	void print( const Message &mesg, std::ostream &out );
 
 public:
 	DefaultMsgPrint( LogLevel level ): MessageHandlerBase( level ) {}
@@ -104,6 +112,28 @@ public:
 	static void setStream( std::ostream &_o );
 };
 
+namespace _internal
+{
+class AsyncWriter;
+}
+
+/**
+ * Message output class which does the formatting and writing in a background thread.
+ * The messages are put into a lock free queue and written in batches by one thread shared by all AsyncMsgPrint handlers.
+ * The output looks like the one of DefaultMsgPrint (and goes to the same stream).
+ * Errors are written before commit returns, all other messages at latest when the last AsyncMsgPrint is deleted.
+ */
+class AsyncMsgPrint : public MessageHandlerBase
+{
+	boost::shared_ptr<_internal::AsyncWriter> m_writer;
+public:
+	AsyncMsgPrint( LogLevel level );
+	void commit( const Message &mesg );
+	bool isThreadSafe()const {return true;}
+	/// Wait until all messages committed so far are written.
+	void flush();
+};
+
 }
 }
 #endif //MESSAGE_H
@@ -19,6 +19,7 @@
 
 #include "progressfeedback.hpp"
 #include "common.hpp"
+#include <boost/thread/locks.hpp>
 
 namespace isis
 {
@@ -33,6 +34,33 @@ ProgressFeedback &ProgressFeedback::operator++()
 
 ProgressFeedback::~ProgressFeedback() {}
 
+LockedFeedback::LockedFeedback( boost::shared_ptr<ProgressFeedback> target ): m_target( target ) {}
+void LockedFeedback::show( size_t max, std::string header )
+{
+	boost::lock_guard<boost::mutex> lock( m_mutex );
+	m_target->show( max, header );
+}
+size_t LockedFeedback::extend( size_t by )
+{
+	boost::lock_guard<boost::mutex> lock( m_mutex );
+	return m_target->extend( by );
+}
+void LockedFeedback::close()
+{
+	boost::lock_guard<boost::mutex> lock( m_mutex );
+	m_target->close();
+}
+size_t LockedFeedback::getMax()
+{
+	boost::lock_guard<boost::mutex> lock( m_mutex );
+	return m_target->getMax();
+}
+size_t LockedFeedback::progress( const std::string message, size_t step )
+{
+	boost::lock_guard<boost::mutex> lock( m_mutex );
+	return m_target->progress( message, step );
+}
+
 void ConsoleFeedback::show( size_t max, std::string header )
 {
 	if( disp )
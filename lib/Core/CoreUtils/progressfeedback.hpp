@@ -22,6 +22,8 @@
 #include <string>
 #include <boost/progress.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace isis
 {
@@ -60,6 +62,23 @@ public:
 /*
  * Most simple implementation of a progress bar on the console
  */
+/**
+ * Forwards all calls to another ProgressFeedback while holding a lock.
+ * Use this to share a ProgressFeedback between threads.
+ */
+class LockedFeedback: public ProgressFeedback
+{
+	const boost::shared_ptr<ProgressFeedback> m_target;
+	boost::mutex m_mutex;
+public:
+	explicit LockedFeedback( boost::shared_ptr<ProgressFeedback> target );
+	void close();
+	size_t getMax();
+	size_t progress( const std::string message = "", size_t step = 1 );
+	void show( size_t max, std::string header = "" );
+	size_t extend( size_t by );
+};
+
 class ConsoleFeedback: public ProgressFeedback
 {
 	boost::scoped_ptr<boost::progress_display> disp;
@@ -12,6 +12,7 @@
 
 #include "propmap.hpp"
 #include <boost/foreach.hpp>
+#include <string.h>
 
 namespace isis
 {
@@ -54,6 +55,23 @@ API_EXCLUDE_END
 // Contructors
 ///////////////////////////////////////////////////////////////////
 
+PropertyMap::PropPath::PropPath( const char *key ) {append( key, key + strlen( key ) );}
+PropertyMap::PropPath::PropPath( const KeyType &key ) {append( key.data(), key.data() + key.length() );}
+
+void PropertyMap::PropPath::append( const char *start, const char *end )
+{
+	// split directly from the characters, without any temporary strings
+	while( start != end ) {
+		if( *start == pathSeperator ) {
+			start++;
+		} else {
+			const char *next = std::find( start, end, pathSeperator );
+			push_back( KeyType( start, next ) );
+			start = next;
+		}
+	}
+}
+
 PropertyMap::PropertyMap( const PropertyMap::Container &src ): Container( src ) {}
 
 bool PropertyMap::operator==( const PropertyMap &src )const
@@ -138,9 +156,10 @@ bool PropertyMap::recursiveRemove( PropertyMap &root, const propPathIterator pat
 			mapped_type &ref = found->second;
 
 			if ( ! ref.is_leaf() && next!=pathEnd) {
-				ret = recursiveRemove( ref.getBranch(), next, pathEnd );
+				PropertyMap &sub = ref.detachBranch();
+				ret = recursiveRemove( sub, next, pathEnd );
 
-				if ( ref.getBranch().isEmpty() )
+				if ( sub.isEmpty() )
 					root.erase( found ); // remove the now empty branch
 			} else {
 				root.erase( found );
@@ -239,9 +258,11 @@ bool PropertyMap::remove( const PropertyMap &removeMap, bool keep_needed )
 	for ( const_iterator otherIt = removeMap.begin(); otherIt != removeMap.end(); otherIt++ ) {
 		//find the closest match for otherIt->first in this (use the value-comparison-functor of PropMap)
 		if ( continousFind( thisIt, end(), *otherIt, value_comp() ) ) { //thisIt->first == otherIt->first - so its the same property or propmap
-			if ( ! thisIt->second.is_leaf() ) { //this is a branch
+			if ( thisIt->second.sharesBranch( otherIt->second ) ) { // its the very same branch, so everything in it would be removed
+				erase( thisIt++ );
+			} else if ( ! thisIt->second.is_leaf() ) { //this is a branch
 				if ( ! otherIt->second.is_leaf() ) { // recurse if its a branch in the removal map as well
-					PropertyMap &mySub = thisIt->second.getBranch();
+					PropertyMap &mySub = thisIt->second.detachBranch();
 					const PropertyMap &otherSub = otherIt->second.getBranch();
 					ret &= mySub.remove( otherSub );
 
@@ -295,7 +316,9 @@ void PropertyMap::diffTree( const PropertyMap &other, PropertyMap::DiffMap &ret,
 		if ( _internal::continousFind( otherIt, other.end(), *thisIt, value_comp() ) ) { //otherIt->first == thisIt->first - so its the same property
 			const mapped_type &first = thisIt->second, &second = otherIt->second;
 
-			if ( ! ( first.is_leaf() || second.is_leaf() ) ) { // if both are a branch
+			if ( first.sharesBranch( second ) ) { // the very same branch - no difference
+				continue;
+			} else if ( ! ( first.is_leaf() || second.is_leaf() ) ) { // if both are a branch
 				const PropertyMap &thisMap = first.getBranch();
 				const PropertyMap &refMap = second.getBranch();
 				thisMap.diffTree( refMap, ret, pathname + "/" );
@@ -365,7 +388,7 @@ void PropertyMap::removeEqual ( const PropertyMap &other, bool removeNeeded )
 					LOG( Debug, verbose_info ) << "Removing " << *thisIt << " because its equal with the other (" << *otherIt << ")";
 					erase( thisIt++ ); // so delete this (they are equal - kind of)
 				} else if ( ! ( thisIt->second.is_leaf() || otherIt->second.is_leaf() ) ) { //but maybe they are branches
-					PropertyMap &thisMap = thisIt->second.getBranch();
+					PropertyMap &thisMap = thisIt->second.detachBranch();
 					const PropertyMap &otherMap = otherIt->second.getBranch();
 					thisMap.removeEqual( otherMap );
 					thisIt++;
@@ -395,8 +418,10 @@ void PropertyMap::joinTree( const PropertyMap &other, bool overwrite, istring pr
 			if ( thisIt->second.empty() ) { // if ours is empty
 				LOG( Debug, verbose_info ) << "Replacing empty property " << MSubject( thisIt->first ) << " by " << MSubject( otherIt->second );
 				thisIt->second.insert( otherIt->second );
+			} else if ( thisIt->second.sharesBranch( otherIt->second ) ) { // the very same subtree - nothing to join
+				continue;
 			} else if ( ! ( thisIt->second.is_leaf() || otherIt->second.is_leaf() ) ) { // if both are a subtree
-				PropertyMap &thisMap = thisIt->second.getBranch();
+				PropertyMap &thisMap = thisIt->second.detachBranch();
 				const PropertyMap &refMap = otherIt->second.getBranch();
 				thisMap.joinTree( refMap, overwrite, prefix + thisIt->first + "/", rejects ); //recursion
 			} else if ( overwrite ) { // otherwise replace ours by the other (if we shall overwrite)
@@ -22,6 +22,7 @@
 #include "istring.hpp"
 #include <set>
 #include <algorithm>
+#include <boost/shared_ptr.hpp>
 
 namespace isis
 {
@@ -48,6 +49,10 @@ class treeNode; //predeclare treeNode -- we'll need it in PropertyMap
  *
  * To describe the minimum of needed metadata needed by specific data structures / subclasses
  * properties can be marked as "needed" and there are functions to verify that they are not empty.
+ *
+ * Branches are shared between copies of a PropertyMap until one of the copies changes them (copy on write).
+ * Once a non-const reference into a branch was handed out (e.g. by propertyValue(), branch() or setPropertyAs()) it is not shared anymore,
+ * copying the map copies such branches right away. So writing through a reference which is held while the map is copied only changes the map it was got from.
  */
 class PropertyMap : protected std::map<util::istring, _internal::treeNode>
 {
@@ -61,12 +66,18 @@ public:
 	///a flat map, matching complete paths as keys to the corresponding values
 	typedef std::map<KeyType, PropertyValue> FlatMap;
 
-	/// "Path" type used to locate entries in the tree
+	/**
+	 * "Path" type used to locate entries in the tree.
+	 * Making a path from a string splits it into its keys, which costs an allocation per key.
+	 * So fixed paths used in loops should be made only once (e.g. as function-local "static const PropPath").
+	 */
 	struct PropPath: public std::list<KeyType> {
 		PropPath() {}
-		PropPath( const char *key ): std::list<KeyType>( util::stringToList<KeyType>( util::istring( key ), pathSeperator ) ) {}
-		PropPath( const KeyType &key ): std::list<KeyType>( util::stringToList<KeyType>( key, pathSeperator ) ) {}
+		PropPath( const char *key );
+		PropPath( const KeyType &key );
 		PropPath( const std::list<KeyType> &path ): std::list<KeyType>( path ) {}
+	private:
+		void append( const char *start, const char *end );
 	};
 private:
 	typedef std::map<KeyType, mapped_type, key_compare> Container;
@@ -141,20 +152,6 @@ protected:
 	 */
 	void removeEqual( const PropertyMap &other, bool removeNeeded = false );
 
-	/**
-	 * Get common and unique properties from the tree.
-	 * For every entry of the tree this checks if it is common/unique and removes/adds it accordingly.
-	 * This is done by:
-	 * - generating a difference (using diff) between the current common and the tree
-	 *   - the resulting diff_map contains all newly unique properties (properties which has been in common, but are not euqual in the tree)
-	 * - these newly diffent properties are removed from common and added to unique.
-	 * - if init is true uniques is cleared and common is replaced by a copy of the tree (shall be done at first step)
-	 * \param common reference of the common-tree
-	 * \param uniques reference of the unique-tree
-	 * \param init if initialisation shall be done instead of normal seperation
-	 */
-	void toCommonUnique( PropertyMap &common, std::set<KeyType> &uniques, bool init )const;
-
 	///copy the tree into a flat key/property-map
 	void makeFlatMap( FlatMap &out, KeyType key_prefix = "" )const;
 
@@ -307,6 +304,20 @@ public:
 	 */
 	DiffMap getDifference( const PropertyMap &second )const;
 
+	/**
+	 * Get common and unique properties from the tree.
+	 * For every entry of the tree this checks if it is common/unique and removes/adds it accordingly.
+	 * This is done by:
+	 * - generating a difference (using diff) between the current common and the tree
+	 *   - the resulting diff_map contains all newly unique properties (properties which has been in common, but are not euqual in the tree)
+	 * - these newly diffent properties are removed from common and added to unique.
+	 * - if init is true uniques is cleared and common is replaced by a copy of the tree (shall be done at first step)
+	 * \param common reference of the common-tree
+	 * \param uniques reference of the unique-tree
+	 * \param init if initialisation shall be done instead of normal seperation
+	 */
+	void toCommonUnique( PropertyMap &common, std::set<KeyType> &uniques, bool init )const;
+
 	/**
 	 * Add Properties from another tree.
 	 * \param other the other tree to join with
@@ -433,25 +444,62 @@ namespace _internal
 /**
  * Basic container class for the "values" inside the property tree.
  * This can hold a list of PropertyValues or another PropertyMap.
+ * Branches are shared between copies of the node until one of them is changed (copy on write).
+ * So copying a PropertyMap only copies its top level, and the same subtrees can be recognized cheaply.
+ * Branches which were handed out for writing are not shared anymore (like the characters of a copy on write std::string).
  */
 class treeNode
 {
-	PropertyMap m_branch;
+	boost::shared_ptr<PropertyMap> m_branch; // NULL for leafs
 	std::vector<PropertyValue> m_leaf;
+	bool m_unshareable; // a non-const reference into the branch was handed out, so copies must get their own branch
+	static const PropertyMap &emptyBranch() {
+		static const PropertyMap empty;
+		return empty;
+	}
+	boost::shared_ptr<PropertyMap> shareBranch()const {
+		return m_unshareable ? boost::shared_ptr<PropertyMap>( new PropertyMap( *m_branch ) ) : m_branch;
+	}
 public:
-	treeNode(): m_leaf( 1 ) {}
+	treeNode(): m_leaf( 1 ), m_unshareable( false ) {}
+	treeNode( const treeNode &ref ): m_branch( ref.shareBranch() ), m_leaf( ref.m_leaf ), m_unshareable( false ) {}
+	treeNode &operator=( const treeNode &ref ) {
+		if( this != &ref ) {
+			m_branch = ref.shareBranch();
+			m_leaf = ref.m_leaf;
+			m_unshareable = false;
+		}
+
+		return *this;
+	}
 	bool empty()const {
-		return m_branch.isEmpty() && m_leaf[0].isEmpty();
+		return getBranch().isEmpty() && m_leaf[0].isEmpty();
 	}
 	bool is_leaf()const {
-		LOG_IF( ! ( m_branch.isEmpty() || m_leaf[0].isEmpty() ), Debug, error ) << "There is a non empty leaf at a branch. This should not be.";
-		return m_branch.isEmpty();
+		LOG_IF( ! ( getBranch().isEmpty() || m_leaf[0].isEmpty() ), Debug, error ) << "There is a non empty leaf at a branch. This should not be.";
+		return getBranch().isEmpty();
 	}
 	const PropertyMap &getBranch()const {
-		return m_branch;
+		return m_branch ? *m_branch : emptyBranch();
+	}
+	/// get the branch for changing it internally, if its shared with other nodes it will be copied first (the result must not be kept)
+	PropertyMap &detachBranch() {
+		if( !m_branch )
+			m_branch.reset( new PropertyMap );
+		else if( !m_branch.unique() )
+			m_branch.reset( new PropertyMap( *m_branch ) );
+
+		return *m_branch;
 	}
+	/// get the branch for writing, it won't be shared with copies of this node anymore
 	PropertyMap &getBranch() {
-		return m_branch;
+		PropertyMap &ret = detachBranch();
+		m_unshareable = true;
+		return ret;
+	}
+	/// \returns true if both nodes share the same (and thus equal) branch
+	bool sharesBranch( const treeNode &ref )const {
+		return m_branch && m_branch == ref.m_branch;
 	}
 	std::vector<PropertyValue> &getLeaf() {
 		assert( is_leaf() );
@@ -462,10 +510,11 @@ public:
 		return m_leaf;
 	}
 	bool operator==( const treeNode &ref )const {
-		return m_branch == ref.m_branch && m_leaf == ref.m_leaf;
+		return ( sharesBranch( ref ) || getBranch() == ref.getBranch() ) && m_leaf == ref.m_leaf;
 	}
 	void insert( const treeNode &ref ) {
-		m_branch = ref.m_branch;
+		m_branch = ref.shareBranch();
+		m_unshareable = false;
 		m_leaf.resize( ref.m_leaf.size() );
 		std::vector<PropertyValue>::iterator dst = m_leaf.begin();
 		const bool needed = dst->isNeeded();
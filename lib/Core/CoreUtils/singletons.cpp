@@ -1,5 +1,6 @@
 #include "singletons.hpp"
 #include <boost/foreach.hpp>
+#include <boost/thread/locks.hpp>
 
 namespace isis
 {
@@ -20,5 +21,11 @@ Singletons::~Singletons()
 }
 Singletons::Singletons() {}
 
+void Singletons::registerDestructer( int prio, destructer destruct )
+{
+	boost::lock_guard<boost::mutex> lock( mutex );
+	map.insert( map.find( prio ), std::make_pair( prio, destruct ) );
+}
+
 }
 }
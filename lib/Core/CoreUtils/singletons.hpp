@@ -6,6 +6,8 @@
 #include <string>
 #include <iostream>
 #include <typeinfo>
+#include <boost/thread/once.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace isis
 {
@@ -27,7 +29,7 @@ namespace util
  * Singletons::get < MyClass, INT_MAX - 1 >
  * \endcode
  * This generates a Singleton of MyClass with highest priority.
- * \note This is (currently) not thread save.
+ * \note The creation of the singletons is thread safe, their usage of course is up to them.
  */
 class Singletons
 {
@@ -38,7 +40,12 @@ class Singletons
 
 			_instance = 0;
 		}
+		template<int PRIO> static void create() {
+			_instance = new C();
+			getMaster().registerDestructer( PRIO, destruct );
+		}
 		static C *_instance;
+		static boost::once_flag _once;
 		Singleton () { }
 	public:
 		friend class Singletons;
@@ -48,26 +55,30 @@ class Singletons
 	typedef std::multimap<int, destructer> prioMap;
 
 	prioMap map;
+	boost::mutex mutex;
 	Singletons();
 	virtual ~Singletons();
 	static Singletons &getMaster();
+	void registerDestructer( int prio, destructer destruct );
 public:
 	/**
 	 * The first call creates a singleton of type T with the priority PRIO (ascending order),
 	 * all repetetive calls return this object.
+	 * If multiple threads do the first call at the same time, only one of them creates the object, the others wait for it.
 	 * \return a reference to the same object of type T.
 	 */
 	template<typename T, int PRIO> static T &get() {
-		if ( !Singleton<T>::_instance ) {
-			Singleton<T>::_instance = new T();
-			prioMap &map = getMaster().map;
-			map.insert( map.find( PRIO ), std::make_pair( PRIO, Singleton<T>::destruct ) );
+		boost::call_once( Singleton<T>::_once, &Singleton<T>::template create<PRIO> );
+
+		if ( !Singleton<T>::_instance ) { // was already destroyed at program exit, so we're single threaded again
+			Singleton<T>::template create<PRIO>();
 		}
 
 		return *Singleton<T>::_instance;
 	}
 };
 template <typename C> C *Singletons::Singleton<C>::_instance = 0;
+template <typename C> boost::once_flag Singletons::Singleton<C>::_once = BOOST_ONCE_INIT;
 
 }
 }
@@ -0,0 +1,171 @@
+/*
+    Copyright (C) 2010  reimer@cbs.mpg.de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "threadpool.hpp"
+#include "message.hpp"
+#include "common.hpp"
+#include <stdlib.h>
+#include <stdexcept>
+#include <boost/lexical_cast.hpp>
+
+namespace isis
+{
+namespace util
+{
+/// @cond _internal
+// a batch is shared by the thread calling run() and the helping workers, the first one taking an index runs the job
+struct ThreadPool::Batch {
+	Batch( const std::vector<job> &_jobs ): jobs( _jobs ), next( 0 ), done( 0 ) {}
+	const std::vector<job> jobs;
+	size_t next, done;
+	std::string error;
+	boost::mutex mutex;
+	boost::condition_variable finished;
+};
+/// @endcond
+
+ThreadPool::ThreadPool( size_t concurrency ): m_stop( false )
+{
+	for( size_t i = 1; i < concurrency; i++ )
+		m_threads.create_thread( boost::bind( &ThreadPool::work, this ) );
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		boost::lock_guard<boost::mutex> lock( m_mutex );
+		m_stop = true;
+	}
+	m_cond.notify_all();
+	m_threads.join_all();
+}
+
+size_t ThreadPool::getConcurrency()const
+{
+	return m_threads.size() + 1;
+}
+
+size_t ThreadPool::getBlocks( size_t len, size_t minBlockSize )const
+{
+	if( m_threads.size() == 0 || len < minBlockSize * 2 )
+		return 1;
+
+	// a few blocks per thread, so threads which got a fast block can help with the rest
+	return std::min( len / minBlockSize, getConcurrency() * 4 );
+}
+
+void ThreadPool::work()
+{
+	boost::unique_lock<boost::mutex> lock( m_mutex );
+
+	while( true ) {
+		while( m_queue.empty() && !m_stop )
+			m_cond.wait( lock );
+
+		if( m_queue.empty() ) // stopped and nothing left to do
+			return;
+
+		const job next = m_queue.front();
+		m_queue.pop_front();
+		lock.unlock();
+		next();
+		lock.lock();
+	}
+}
+
+void ThreadPool::process( boost::shared_ptr<Batch> batch )
+{
+	boost::unique_lock<boost::mutex> lock( batch->mutex );
+
+	while( batch->next < batch->jobs.size() ) {
+		const size_t index = batch->next++;
+		std::string error;
+		lock.unlock();
+
+		try {
+			batch->jobs[index]();
+		} catch( const std::exception &e ) {
+			error = e.what();
+		} catch( ... ) {
+			error = "unknown exception";
+		}
+
+		lock.lock();
+
+		if( !error.empty() && batch->error.empty() )
+			batch->error = error;
+
+		if( ++batch->done == batch->jobs.size() )
+			batch->finished.notify_all();
+	}
+}
+
+void ThreadPool::run( const std::vector<job> &jobs )
+{
+	if( m_threads.size() == 0 || jobs.size() < 2 ) {
+		for( std::vector<job>::const_iterator i = jobs.begin(); i != jobs.end(); ++i )
+			( *i )();
+
+		return;
+	}
+
+	const boost::shared_ptr<Batch> batch( new Batch( jobs ) );
+	{
+		// wake up as many workers as can be useful, the calling thread takes one job itself
+		boost::lock_guard<boost::mutex> lock( m_mutex );
+
+		for( size_t i = 0; i < std::min( m_threads.size(), jobs.size() - 1 ); i++ )
+			m_queue.push_back( boost::bind( &ThreadPool::process, batch ) );
+	}
+	m_cond.notify_all();
+
+	process( batch );
+
+	boost::unique_lock<boost::mutex> lock( batch->mutex );
+
+	while( batch->done < batch->jobs.size() )
+		batch->finished.wait( lock );
+
+	if( !batch->error.empty() )
+		throw std::runtime_error( batch->error );
+}
+
+ThreadPool &ThreadPool::global()
+{
+	static ThreadPool pool( getGlobalConcurrency() );
+	return pool;
+}
+
+size_t ThreadPool::getGlobalConcurrency()
+{
+	size_t ret = boost::thread::hardware_concurrency();
+	const char *env = getenv( "ISIS_THREADS" );
+
+	if( env ) {
+		try {
+			ret = boost::lexical_cast<size_t>( env );
+		} catch( const boost::bad_lexical_cast & ) {
+			LOG( Runtime, warning ) << "Ignoring invalid value " << MSubject( env ) << " of ISIS_THREADS";
+		}
+	}
+
+	return std::max<size_t>( ret, 1 );
+}
+
+}
+}
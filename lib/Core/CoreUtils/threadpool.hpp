@@ -0,0 +1,114 @@
+/*
+    Copyright (C) 2010  reimer@cbs.mpg.de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <boost/function.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace isis
+{
+namespace util
+{
+/**
+ * A fixed set of worker threads to run jobs in parallel.
+ * Jobs are handed in as batches to run(), which blocks until all jobs of the batch are done.
+ * The calling thread works on its own batch as well, so run() can safely be called from within a job.
+ * Exceptions thrown by a job are caught and rethrown as std::runtime_error by run().
+ *
+ * All parallel code in isis should use the pool returned by global() instead of starting its own threads.
+ */
+class ThreadPool: boost::noncopyable
+{
+public:
+	typedef boost::function<void()> job;
+
+	/**
+	 * Create a pool running up to the given number of jobs at once.
+	 * As the calling thread of run() counts as one, concurrency-1 worker threads are started.
+	 * \param concurrency maximum number of jobs running in parallel (0 and 1 both mean "no threads at all")
+	 */
+	explicit ThreadPool( size_t concurrency );
+	/// Finishes all queued work and stops the worker threads.
+	~ThreadPool();
+
+	/// \returns the maximum number of jobs running in parallel (worker threads + the calling thread)
+	size_t getConcurrency()const;
+
+	/**
+	 * Run all given jobs and wait for them to finish.
+	 * If there are no worker threads, the jobs are simply run one after another by the calling thread.
+	 */
+	void run( const std::vector<job> &jobs );
+
+	/**
+	 * Get the number of blocks forEachBlock will split the given length into.
+	 * \param len the overall number of elements
+	 * \param minBlockSize the minimal number of elements per block
+	 * \returns 1 if splitting is not worth it, a few blocks per thread otherwise
+	 */
+	size_t getBlocks( size_t len, size_t minBlockSize )const;
+
+	/**
+	 * Split the range [0,len) into getBlocks(len,minBlockSize) adjacent blocks and process them in parallel.
+	 * \param op a copyable functor which will be called as op(block,start,end) for each block
+	 */
+	template<typename OP> void forEachBlock( size_t len, size_t minBlockSize, OP op ) {
+		const size_t blocks = getBlocks( len, minBlockSize );
+
+		if( blocks < 2 ) {
+			op( 0, 0, len );
+		} else {
+			std::vector<job> jobs;
+			jobs.reserve( blocks );
+
+			for( size_t b = 0; b < blocks; b++ )
+				jobs.push_back( boost::bind<void>( op, b, len * b / blocks, len * ( b + 1 ) / blocks ) );
+
+			run( jobs );
+		}
+	}
+
+	/**
+	 * Get the global pool of isis.
+	 * Its concurrency is the number of cpu cores, or the value of the environment variable ISIS_THREADS if that is set.
+	 */
+	static ThreadPool &global();
+private:
+	struct Batch;
+	static void process( boost::shared_ptr<Batch> batch );
+	static size_t getGlobalConcurrency();
+	void work();
+
+	boost::thread_group m_threads;
+	std::deque<job> m_queue;
+	boost::mutex m_mutex;
+	boost::condition_variable m_cond;
+	bool m_stop;
+};
+}
+}
+#endif // THREADPOOL_HPP
@@ -65,6 +65,9 @@ protected:
 	virtual bool inRange( const util::Value<T> &/*first*/, const util::Value<T> &/*second*/ )const {return false;} //default to false
 public:
 	bool operator()( const util::Value<T> &first, const ValueBase &second )const {
+		if( second.is<T>() ) // no need for a conversion if both have the same type (this is the common case e.g. when sorting chunks)
+			return inRange( first, second.castToType<T>() );
+
 		// ask second for a converter from itself to Value<T>
 		const ValueBase::Converter conv = second.getConverterTo( util::Value<T>::staticID );
 
@@ -103,27 +103,19 @@ public:
 // some helper
 /////////////////////////////////////////////////////////////////////////////
 
-// global numeric overflow handler @todo this is NOT thread-safe
-struct NumericOverflowHandler {
-	static boost::numeric::range_check_result result;
-	void operator() ( boost::numeric::range_check_result r ) { // throw bad_numeric_conversion derived
-		result = r;
-	}
-};
-boost::numeric::range_check_result NumericOverflowHandler::result = boost::numeric::cInRange;
-
 // basic numeric to numeric conversion (does runding and handles overlow)
+// the range is checked explicitly instead of recording it in an overflow handler, so there is no shared state between threads
 template<typename SRC, typename DST> boost::numeric::range_check_result num2num( const SRC &src, DST &dst )
 {
 	typedef boost::numeric::converter <
 	DST, SRC,
 	   boost::numeric::conversion_traits<DST, SRC>,
-	   NumericOverflowHandler,
+	   boost::numeric::silent_overflow_handler,
 	   boost::numeric::RoundEven<SRC>
 	   > converter;
-	NumericOverflowHandler::result = boost::numeric::cInRange;
+	const boost::numeric::range_check_result result = converter::out_of_range( src );
 	dst = converter::convert( src );
-	return NumericOverflowHandler::result;
+	return result;
 }
 
 template<typename DST> boost::numeric::range_check_result str2scalar( const std::string &src, DST &dst )
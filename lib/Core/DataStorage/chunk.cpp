@@ -37,6 +37,24 @@ ChunkBase::ChunkBase ( size_t nrOfColumns, size_t nrOfRows, size_t nrOfSlices, s
 
 ChunkBase::~ChunkBase() { }
 
+void reverseBlocks( uint8_t *start, const uint8_t *const end, size_t block_bytes, size_t count, uint8_t *buff )
+{
+	const size_t swap_volume = block_bytes * count;
+
+	//iterate over all swap-volumes
+	for( ; start < end; start += swap_volume ) { //outer loop
+		// swap each block with the one at the oppsite end of the swap_volume
+		uint8_t *a = start; //first block
+		uint8_t *b = start + swap_volume - block_bytes; //last block within the swap-volume
+
+		for( ; a < b; a += block_bytes, b -= block_bytes ) { // grow a, shrink b (inner loop)
+			memcpy( buff, a, block_bytes );
+			memcpy( a, b, block_bytes );
+			memcpy( b, buff, block_bytes );
+		}
+	}
+}
+
 }
 /// @endcond _internal
 
@@ -82,6 +100,76 @@ bool Chunk::convertToType( short unsigned int ID, scaling_pair scaling )
 	return true;
 }
 
+bool Chunk::copyToValueArray( ValueArrayBase &dst, scaling_pair scaling, const std::set<dimensions> &flips ) const
+{
+	const util::vector4<size_t> size = getSizeAsVector();
+	const size_t volume = getVolume();
+	const ValueArrayBase &src = getValueArrayBase();
+
+	if( dst.getLength() < volume ) {
+		LOG( Runtime, error ) << "Won't copy " << volume << " voxels into a ValueArray of length " << dst.getLength();
+		return false;
+	}
+
+	// flipping along dimensions of size 1 is a no-op
+	std::set<dimensions> relevant_flips;
+
+	for( std::set<dimensions>::const_iterator i = flips.begin(); i != flips.end(); ++i )
+		if( size[*i] > 1 )
+			relevant_flips.insert( *i );
+
+	if( relevant_flips.empty() )
+		return src.copyTo( dst, scaling );
+
+	// the scaling must be computed for the whole chunk, not for the blocks
+	if( scaling.first.isEmpty() || scaling.second.isEmpty() )
+		scaling = src.getScalingTo( dst.getTypeID() );
+
+	// The chunk is converted in contiguous units which are written to their flipped position in dst.
+	// Units are made of the dimensions below the lowest flip, if that's too small for an efficient conversion
+	// further dimensions are added and flipping along them is done in place right after the unit was converted.
+	size_t unit_dims = *relevant_flips.begin(), unit = 1;
+
+	for( size_t d = 0; d < unit_dims; d++ )
+		unit *= size[d];
+
+	for( ; unit < 4096 && unit_dims < 4; unit_dims++ )
+		unit *= size[unit_dims];
+
+	const size_t units = volume / unit;
+	const size_t elSize = dst.bytesPerElem();
+	const std::vector<ValueArrayReference> from = units > 1 ? src.splice( unit ) : std::vector<ValueArrayReference>( 1, src );
+	const std::vector<ValueArrayReference> to = units > 1 ? dst.splice( unit ) : std::vector<ValueArrayReference>( 1, dst );
+	const boost::scoped_array<uint8_t> buff( new uint8_t[ unit * elSize ] );
+
+	LOG( Debug, verbose_info ) << "Copying " << units << " units of " << unit << " voxels flipped along " << util::listToString( relevant_flips.begin(), relevant_flips.end() );
+
+	for( size_t u = 0; u < units; u++ ) {
+		size_t coords[4];
+		getCoordsFromLinIndex( u * unit, coords );
+
+		for( std::set<dimensions>::const_iterator i = relevant_flips.lower_bound( static_cast<dimensions>( unit_dims ) ); i != relevant_flips.end(); ++i )
+			coords[*i] = size[*i] - coords[*i] - 1;
+
+		ValueArrayBase &target = *to[getLinearIndex( coords ) / unit];
+
+		if( !from[u]->copyTo( target, scaling ) )
+			return false;
+
+		if( *relevant_flips.begin() < unit_dims ) { // flip the remaining dimensions while the data are still in the cache
+			uint8_t *const start = boost::static_pointer_cast<uint8_t>( target.getRawAddress() ).get();
+			size_t block = elSize;
+
+			for( size_t d = 0; d < unit_dims; block *= size[d++] ) {
+				if( relevant_flips.find( static_cast<dimensions>( d ) ) != relevant_flips.end() )
+					_internal::reverseBlocks( start, start + unit * elSize, block, size[d], buff.get() );
+			}
+		}
+	}
+
+	return true;
+}
+
 Chunk Chunk::copyByID( short unsigned int ID, scaling_pair scaling ) const
 {
 	Chunk ret = *this; //make copy of the chunk
@@ -149,7 +237,7 @@ size_t Chunk::compareRange( const size_t source_start[], const size_t source_end
 size_t Chunk::compare( const isis::data::Chunk &dst ) const
 {
 	if( getSizeAsVector() == dst.getSizeAsVector() )
-		return getValueArrayBase().compare( 0, getVolume() - 1, dst.getValueArrayBase(), 0 );
+		return getValueArrayBase().compare( 0, getVolume(), dst.getValueArrayBase(), 0 );
 	else
 		return std::max( getVolume(), dst.getVolume() );
 }
@@ -222,9 +310,10 @@ std::list<Chunk> Chunk::autoSplice ( uint32_t acquisitionNumberStride )const
 	}
 
 	// prepare some attributes
+	static const util::PropertyMap::PropPath indexOriginProp( "indexOrigin" ), acquisitionNumberProp( "acquisitionNumber" );
 	const util::fvector3 indexOriginOffset = atDim < data::timeDim ? offset * distance[atDim] : util::fvector3();
-	const bool acqWasList=propertyValueVec("acquisitionNumber").size()==getDimSize(atDim);
-	const bool originWasList=propertyValueVec("indexOrigin").size()==getDimSize(atDim);
+	const bool acqWasList=propertyValueVec(acquisitionNumberProp).size()==getDimSize(atDim);
+	const bool originWasList=propertyValueVec(indexOriginProp).size()==getDimSize(atDim);
 	
 	LOG( Debug, info ) << "Splicing chunk at dimenstion " << atDim + 1 << " with indexOrigin stride " << indexOriginOffset << " and acquisitionNumberStride " << acquisitionNumberStride;
 	std::list<Chunk> ret = splice( ( dimensions )atDim ); // do low level splice - get the chunklist
@@ -234,20 +323,20 @@ std::list<Chunk> Chunk::autoSplice ( uint32_t acquisitionNumberStride )const
 
 	for( uint32_t cnt = 1; it != ret.end(); it++, cnt++ ) { // adapt some metadata in them @todo API cleanup wehn Value has operators
 		if(!originWasList){
-			util::fvector3 &orig = it->propertyValue( "indexOrigin" ).castTo<util::fvector3>();
+			util::fvector3 &orig = it->propertyValue( indexOriginProp ).castTo<util::fvector3>();
 
-			if( orig == ret.front().getPropertyAs<util::fvector3>( "indexOrigin" ) ) { // fix pos if its the same as for the first
+			if( orig == ret.front().propertyValue( indexOriginProp ).castTo<util::fvector3>() ) { // fix pos if its the same as for the first
 				LOG( Debug, verbose_info ) << "Origin was " << orig << " will be moved by " << indexOriginOffset << "*"  << cnt;
 				orig = orig + indexOriginOffset * ( float )cnt;
 			}
 		}
 
 		if(!acqWasList && acquisitionNumberStride){
-			util::PropertyValue acqVal = it->propertyValue( "acquisitionNumber" );//@todo acquisitionTime needs to be fixed as well
+			util::PropertyValue acqVal = it->propertyValue( acquisitionNumberProp );//@todo acquisitionTime needs to be fixed as well
 
-			if( acqVal == ret.front().propertyValue( "acquisitionNumber" ) ) {
+			if( acqVal == ret.front().propertyValue( acquisitionNumberProp ) ) {
 				LOG( Debug, verbose_info ) << "acquisitionNumber was " << acqVal << " will be moved by " << acquisitionNumberStride << "*"  << cnt;
-				it->setPropertyAs<uint32_t>( "acquisitionNumber",acqVal.as<uint32_t>() + acquisitionNumberStride * cnt); //@todo this might cause trouble if we try to insert this chunks into an image
+				it->setPropertyAs<uint32_t>( acquisitionNumberProp,acqVal.as<uint32_t>() + acquisitionNumberStride * cnt); //@todo this might cause trouble if we try to insert this chunks into an image
 			}
 		}
 	}
@@ -272,17 +361,22 @@ std::list<Chunk> Chunk::splice ( dimensions atDim )const
 	const util::PropertyMap::KeyList lists = this->findLists();
 	size_t block_idx = 0;
 
+	// the properties which are the same for all splices
+	// the lists are left out - each splice only gets its own part of them
+	// removing them copies the branches holding lists (usually DICOM/), only branches without lists stay shared with this chunk
+	util::PropertyMap common = *this;
+	common.remove( lists );
+
 	//create new Chunks from this ValueArray's
 	BOOST_FOREACH( ValueArrayList::const_reference ref, pointers ) {
 		ret.push_back( Chunk( ref, spliceSize[0], spliceSize[1], spliceSize[2], spliceSize[3] ) ); //@todo make sure this is only one copy-operation
-		static_cast<util::PropertyMap &>( ret.back() ) = static_cast<const util::PropertyMap &>( *this ); // copy all props into the splices
-		BOOST_FOREACH( const util::PropertyMap::KeyType & key, lists ) { // override list-entries in the splices with their respective entries
+		static_cast<util::PropertyMap &>( ret.back() ) = common; // copy the common props into the splices (the branches are copied only where a splice adds its list entries)
+		BOOST_FOREACH( const util::PropertyMap::KeyType & key, lists ) { // add the list-entries to the splices with their respective entries
 			const std::vector<util::PropertyValue> &org=this->propertyValueVec(key);
 			if(org.size()<pointers.size() || org.size()%pointers.size()){
 				LOG(Runtime,warning)
 				<< "Dropping invalid property list " << std::make_pair(key,util::listToString(org.begin(),org.end()))
 				<< " (its length " << org.size() << " doesn't fit the splicing size "<< pointers.size() << ")";
-				ret.back().remove(key);
 			} else {
 				const size_t stride=org.size()/pointers.size();
 				const std::vector< util::PropertyValue >::const_iterator start=org.begin()+block_idx*stride,end=start+stride;
@@ -305,9 +399,6 @@ void Chunk::swapAlong( const dimensions dim ) const
 	const util::vector4<size_t> whole_size = getSizeAsVector();
 
 	boost::shared_ptr<uint8_t> swap_ptr = boost::static_pointer_cast<uint8_t>( get()->getRawAddress() );
-	uint8_t *swap_start = swap_ptr.get();
-	const uint8_t *const swap_end = swap_start + whole_size.product() * elSize;
-
 	size_t block_volume = whole_size.product();
 
 	for( int i = data::timeDim; i >= dim; i-- ) {
@@ -317,22 +408,9 @@ void Chunk::swapAlong( const dimensions dim ) const
 
 	assert( block_volume );
 	block_volume *= elSize;
-	const size_t swap_volume = block_volume * whole_size[dim];
 	const boost::scoped_array<uint8_t> buff( new uint8_t[ block_volume ] );
 
-	//iterate over all swap-volumes
-	for( ; swap_start < swap_end; swap_start += swap_volume ) { //outer loop
-		// swap each block with the one at the oppsite end of the swap_volume
-		uint8_t *a = swap_start; //first block
-		uint8_t *b = swap_start + swap_volume - block_volume; //last block within the swap-volume
-
-		for( ; a < b; a += block_volume, b -= block_volume ) { // grow a, shrink b (inner loop)
-			memcpy( buff.get(), a, block_volume );
-			memcpy( a, b, block_volume );
-			memcpy( b, buff.get(), block_volume );
-		}
-
-	}
+	_internal::reverseBlocks( swap_ptr.get(), swap_ptr.get() + whole_size.product() * elSize, block_volume, whole_size[dim], buff.get() );
 }
 
 util::PropertyValue &Chunk::propertyValueAt( const util::PropertyMap::KeyType &key, size_t at )
@@ -14,11 +14,13 @@
 #define CHUNK_H
 
 #include "valuearray.hpp"
+#include "valuearray_view.hpp"
 #include "../CoreUtils/log.hpp"
 #include "../CoreUtils/propmap.hpp"
 #include "common.hpp"
 #include <string.h>
 #include <list>
+#include <set>
 #include "ndimensional.hpp"
 #include "../CoreUtils/vector.hpp"
 
@@ -57,6 +59,8 @@ public:
 	virtual ~VoxelOp() {}
 };
 
+template<typename TYPE, typename OP> size_t forEachVoxel( Chunk &ch, OP &op, util::vector4<size_t> offset = util::vector4<size_t>() );
+
 /**
  * Main class for four-dimensional random-access data blocks.
  * Like in ValueArray, the copy of a Chunk will reference the same data. (cheap copy)
@@ -134,20 +138,7 @@ public:
 	 * \returns amount of operations which returned false - so 0 is good!
 	 */
 	template <typename TYPE> size_t foreachVoxel( VoxelOp<TYPE> &op, util::vector4<size_t> offset ) {
-		const util::vector4<size_t> imagesize = getSizeAsVector();
-		util::vector4<size_t> pos;
-		TYPE *vox = &asValueArray<TYPE>()[0];
-		size_t ret = 0;
-
-		for( pos[timeDim] = 0; pos[timeDim] < imagesize[timeDim]; pos[timeDim]++ )
-			for( pos[sliceDim] = 0; pos[sliceDim] < imagesize[sliceDim]; pos[sliceDim]++ )
-				for( pos[columnDim] = 0; pos[columnDim] < imagesize[columnDim]; pos[columnDim]++ )
-					for( pos[rowDim] = 0; pos[rowDim] < imagesize[rowDim]; pos[rowDim]++ ) {
-						if( op( *( vox++ ), pos + offset ) == false )
-							++ret;
-					}
-
-		return ret;
+		return forEachVoxel<TYPE>( *this, op, offset );
 	}
 
 	/**
@@ -197,6 +188,15 @@ public:
 	template<typename T> bool copyToMem( T *dst, size_t len, scaling_pair scaling = scaling_pair() )const {
 		return getValueArrayBase().copyToMem<T>( dst, len,  scaling ); // use copyToMem of ValueArrayBase
 	}
+	/**
+	 * Copy all voxel data of the chunk into an existing ValueArray, converting and flipping them on the way.
+	 * This is done in one pass without any intermediate copy, so dst can directly be a part of a mapped file (see FilePtr::atByID).
+	 * \param dst the ValueArray to write into (must have at least getVolume() elements)
+	 * \param scaling the scaling to be used when converting the data (will be determined automatically if not given)
+	 * \param flips the dimensions along which the data shall be flipped (dimensions of size 1 are ignored)
+	 * \return true if copying was successful
+	 */
+	bool copyToValueArray( ValueArrayBase &dst, scaling_pair scaling = scaling_pair(), const std::set<dimensions> &flips = std::set<dimensions>() )const;
 	/**
 	 * Create a new Chunk of the requested type and copy all voxel data of the chunk into it.
 	 * If neccessary a conversion into the requested type is done using the given scale.
@@ -206,6 +206,15 @@ public:
 	 */
 	Chunk copyByID( unsigned short ID = 0, scaling_pair scaling = scaling_pair() )const;
 
+	/**
+	 * Get a view of the voxel data as the requested type, which converts the voxels on demand (see ValueArrayView).
+	 * Unlike convertToType or copyByID this does not allocate a converted copy of all voxels.
+	 * \param scaling the scaling to be used when converting the data (will be determined automatically if not given)
+	 */
+	template<typename T> ValueArrayView<T> getViewAs( scaling_pair scaling = scaling_pair() )const {
+		return ValueArrayView<T>( getValueArrayBase(), scaling );
+	}
+
 	///get the scaling (and offset) which would be used in an conversion to the given type
 	scaling_pair getScalingTo( unsigned short typeID, autoscaleOption scaleopt = autoscale )const;
 	scaling_pair getScalingTo( unsigned short typeID, const std::pair<util::ValueReference, util::ValueReference> &minmax, autoscaleOption scaleopt = autoscale )const;
@@ -283,6 +292,39 @@ public:
 	const util::PropertyValue &propertyValueAt( const util::PropertyMap::KeyType &key, size_t at )const;
 };
 
+/**
+ * Run a functor on every voxel of the chunk.
+ * Other than Chunk::foreachVoxel this takes any functor, not only those derived from VoxelOp.
+ * So the call of op can be inlined, which makes this the preferred way for kernels working on single voxels.
+ * The voxels are visited in memory order and the position is advanced along with them.
+ * \param ch the chunk to work on, if its data are not of type TYPE nothing is done
+ * \param op a functor which will be called as op(TYPE &vox, const util::vector4<size_t> &pos) and returns false on failure
+ * \param offset offset to be added to the voxel position before op is called
+ * \returns amount of operations which returned false - so 0 is good! (all voxels count as failed if the type does not fit)
+ */
+template<typename TYPE, typename OP> size_t forEachVoxel( Chunk &ch, OP &op, util::vector4<size_t> offset )
+{
+	if( !ch.getValueArrayBase().is<TYPE>() ) {
+		LOG( Debug, error ) << "Cannot run a voxel operation for " << ValueArray<TYPE>::staticName() << " on a chunk of type " << ch.getTypeName();
+		return ch.getVolume();
+	}
+
+	const util::vector4<size_t> end = ch.getSizeAsVector() + offset;
+	TYPE *vox = &ch.asValueArray<TYPE>()[0];
+	util::vector4<size_t> pos;
+	size_t ret = 0;
+
+	for( pos[timeDim] = offset[timeDim]; pos[timeDim] < end[timeDim]; pos[timeDim]++ )
+		for( pos[sliceDim] = offset[sliceDim]; pos[sliceDim] < end[sliceDim]; pos[sliceDim]++ )
+			for( pos[columnDim] = offset[columnDim]; pos[columnDim] < end[columnDim]; pos[columnDim]++ )
+				for( pos[rowDim] = offset[rowDim]; pos[rowDim] < end[rowDim]; pos[rowDim]++ ) {
+					if( op( *( vox++ ), pos ) == false )
+						++ret;
+				}
+
+	return ret;
+}
+
 /// Chunk class for memory-based buffers
 template<typename TYPE> class MemChunk : public Chunk
 {
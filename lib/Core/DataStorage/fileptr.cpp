@@ -14,10 +14,17 @@
 #endif
 
 #include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
 #include <fcntl.h>
 #include <unistd.h>
 #include <boost/mpl/for_each.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/once.hpp>
 #include "../CoreUtils/singletons.hpp"
+#include "../CoreUtils/threadpool.hpp"
 
 // we need that, because boost::mpl::for_each will instantiate all types - and this needs the output stream operations
 #include <boost/date_time/gregorian/gregorian.hpp>
@@ -79,6 +86,68 @@ void FilePtr::Closer::operator()( void *p )
 	}
 }
 
+/// @cond _internal
+namespace _internal
+{
+size_t getPageSize()
+{
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return info.dwPageSize;
+#else
+	return sysconf( _SC_PAGESIZE );
+#endif
+}
+#ifndef WIN32
+bool adviseRange( void *at, size_t len, int advice, const char *name )
+{
+	if( madvise( at, len, advice ) == 0 ) {
+		return true;
+	} else {
+		LOG( Debug, info ) << "Advising " << name << " for " << len << " bytes at " << at << " failed, the error was: " << util::MSubject( strerror( errno ) );
+		errno = 0; // its just a hint, so don't confuse callers checking errno
+		return false;
+	}
+}
+#endif
+// read one byte of every page, so all of them get mapped
+void touchPages( const uint8_t *at, size_t len, size_t pagesize )
+{
+	volatile uint8_t sink = 0;
+
+	for( size_t i = 0; i < len; i += pagesize )
+		sink += at[i];
+}
+#ifndef WIN32
+// reads the parts [start*blocksize,end*blocksize) of a file into buff (see FilePtr::read)
+struct ReadBlocks {
+	int file;
+	uint8_t *buff;
+	size_t filesize, buffsize, blocksize;
+	int *errors;
+	void operator()( size_t block, size_t start, size_t end )const {
+		const size_t stop = std::min( end * blocksize, buffsize );
+
+		for( size_t pos = start * blocksize; pos < stop && !errors[block]; ) {
+			const ssize_t red = pread( file, buff + pos, std::min( blocksize, stop - pos ), pos );
+
+			if( red > 0 )
+				pos += red;
+			else if( red == 0 ) { // end of the file (buff is bigger than the file to allow aligned reads)
+				if( pos < filesize )
+					errors[block] = EIO; // the file got shorter since we checked its size
+
+				break;
+			} else if( errno != EINTR )
+				errors[block] = errno;
+		}
+	}
+};
+#endif
+}
+/// @endcond _internal
+
 FilePtr::GeneratorMap::GeneratorMap()
 {
 	boost::mpl::for_each<util::_internal::types>( proc( this ) );
@@ -86,7 +155,7 @@ FilePtr::GeneratorMap::GeneratorMap()
 }
 
 
-bool FilePtr::map( FILE_HANDLE file, size_t len, bool write, const boost::filesystem::path &filename )
+bool FilePtr::map( FILE_HANDLE file, size_t len, bool write, const boost::filesystem::path &filename, int hints )
 {
 	void *ptr = NULL;
 	FILE_HANDLE mmaph = 0;
@@ -98,7 +167,25 @@ bool FilePtr::map( FILE_HANDLE file, size_t len, bool write, const boost::filesy
 	}
 
 #else
-	ptr = mmap( 0, len, PROT_WRITE | PROT_READ, write ? MAP_SHARED : MAP_PRIVATE , file, 0 ); // yes we say PROT_WRITE here also if the file is opened ro - its for the mapping, not for the file
+	int flags = write ? MAP_SHARED : MAP_PRIVATE;
+#ifdef MAP_POPULATE
+
+	// let mmap read the file instead of advise touching every page
+	// but only for shared mappings, MAP_POPULATE on a private writable mapping would copy every page
+	// private ones are populated by advise (MADV_POPULATE_READ), which maps the pages of the file read-only until they are written to
+	if( write && ( hints & access_populate ) ) {
+		flags |= MAP_POPULATE;
+		hints &= ~access_populate;
+	}
+
+#endif
+	// yes we say PROT_WRITE here also if the file is opened ro - its for the mapping, not for the file
+	// the chunks of loaded images point into the mapping, and they may be changed (which will cause a copy-on-write of the touched pages)
+	ptr = mmap( 0, len, PROT_WRITE | PROT_READ, flags, file, 0 );
+
+	if( ptr == MAP_FAILED )
+		ptr = NULL;
+
 #endif
 
 	if( ptr == NULL ) {
@@ -108,6 +195,10 @@ bool FilePtr::map( FILE_HANDLE file, size_t len, bool write, const boost::filesy
 		const Closer cl = {file, mmaph, len, filename, write};
 		writing = write;
 		static_cast<ValueArray<uint8_t>&>( *this ) = ValueArray<uint8_t>( static_cast<uint8_t * const>( ptr ), len, cl );
+
+		if( hints != access_normal )
+			advise( hints );
+
 		return true;
 	}
 }
@@ -165,10 +256,112 @@ size_t FilePtr::checkSize( bool write, FILE_HANDLE file, const boost::filesystem
 	}
 }
 
+bool FilePtr::read( FILE_HANDLE file, size_t len, const boost::filesystem::path &filename, readMode mode, int hints )
+{
+#ifdef WIN32
+	LOG( Debug, info ) << "Reading files at once is not supported on this platform, mapping " << util::MSubject( filename ) << " instead";
+	return map( file, len, false, filename, hints );
+#else
+	// O_DIRECT needs the memory, the position in the file and the length of each read aligned to the blocks of the device (pages are big enough)
+	const size_t pagesize = _internal::getPageSize(), buffsize = ( ( len + pagesize - 1 ) / pagesize ) * pagesize;
+	void *buff = NULL;
+
+	if( posix_memalign( &buff, pagesize, buffsize ) != 0 ) {
+		LOG( Runtime, error ) << "Failed to allocate " << buffsize << " bytes to read " << util::MSubject( filename );
+		return false;
+	}
+
+#ifdef MADV_HUGEPAGE
+
+	if( hints & access_hugepages )
+		_internal::adviseRange( buff, buffsize, MADV_HUGEPAGE, "MADV_HUGEPAGE" );
+
+#endif
+
+	int src = -1;
+
+	if( mode == read_direct ) {
+#ifdef O_DIRECT
+		src = open( filename.native().c_str(), O_RDONLY | O_DIRECT );
+		LOG_IF( src == -1, Runtime, info )
+				<< "Cannot open " << util::MSubject( filename ) << " for direct reading (" << strerror( errno ) << "), reading it through the page cache instead";
+#else
+		LOG( Runtime, info ) << "Direct reading is not supported on this platform, reading " << util::MSubject( filename ) << " through the page cache instead";
+#endif
+	}
+
+	if( src == -1 ) {
+		src = file;
+#ifdef POSIX_FADV_SEQUENTIAL
+		posix_fadvise( file, 0, len, POSIX_FADV_SEQUENTIAL );
+#endif
+	}
+
+	// read big blocks in parallel, network filesystems serve several requests at once faster than one after the other
+	static const size_t blocksize = 8 * 1024 * 1024;
+	const size_t blocks = ( buffsize + blocksize - 1 ) / blocksize;
+	util::ThreadPool &pool = util::ThreadPool::global();
+	std::vector<int> errors( pool.getBlocks( blocks, 1 ), 0 );
+	const _internal::ReadBlocks op = {src, static_cast<uint8_t *>( buff ), len, buffsize, blocksize, &errors[0]};
+	pool.forEachBlock( blocks, 1, op );
+
+	if( src != file )
+		::close( src );
+
+	const std::vector<int>::const_iterator failed = std::find_if( errors.begin(), errors.end(), std::bind2nd( std::not_equal_to<int>(), 0 ) );
+
+	if( failed != errors.end() ) {
+		free( buff );
+
+		if( src != file ) { // direct reading may fail on some filesystems only when actually reading
+			LOG( Runtime, info ) << "Direct reading of " << util::MSubject( filename ) << " failed (" << strerror( *failed ) << "), reading it through the page cache instead";
+			return read( file, len, filename, read_pread, hints );
+		}
+
+		LOG( Runtime, error ) << "Failed to read " << util::MSubject( filename ) << ", the error was: " << util::MSubject( strerror( *failed ) );
+		errno = *failed;
+		return false;
+	}
+
+	writing = false;
+	static_cast<ValueArray<uint8_t>&>( *this ) = ValueArray<uint8_t>( static_cast<uint8_t *>( buff ), len ); // uses free() to release buff
+	return true;
+#endif
+}
+
+namespace
+{
+boost::once_flag default_read_mode_once = BOOST_ONCE_INIT;
+boost::atomic<FilePtr::readMode> default_read_mode( FilePtr::read_mmap );
+
+void readDefaultReadModeFromEnv()
+{
+	const char *env = getenv( "ISIS_FILE_READ" );
+	const std::string name = env ? env : "mmap";
+
+	if( name == "pread" )
+		default_read_mode = FilePtr::read_pread;
+	else if( name == "direct" )
+		default_read_mode = FilePtr::read_direct;
+	else
+		LOG_IF( name != "mmap", Runtime, warning ) << "Ignoring unknown read mode " << util::MSubject( name ) << " in ISIS_FILE_READ (use mmap, pread or direct)";
+}
+}
+void FilePtr::setDefaultReadMode( readMode mode )
+{
+	boost::call_once( default_read_mode_once, readDefaultReadModeFromEnv ); // so the environment won't overwrite it later
+	default_read_mode = ( mode == read_default ) ? read_mmap : mode;
+}
+FilePtr::readMode FilePtr::getDefaultReadMode()
+{
+	boost::call_once( default_read_mode_once, readDefaultReadModeFromEnv );
+	return default_read_mode;
+}
+
 FilePtr::FilePtr(): m_good( false ) {}
 
 
-FilePtr::FilePtr( const boost::filesystem::path &filename, size_t len, bool write ): m_good( false )
+FilePtr::FilePtr( const boost::filesystem::path &filename, size_t len, bool write, int hints, readMode mode ): m_good( false )
 {
 #ifdef WIN32
 	const FILE_HANDLE invalid = INVALID_HANDLE_VALUE;
@@ -194,14 +387,79 @@ FilePtr::FilePtr( const boost::filesystem::path &filename, size_t len, bool writ
 
 	const size_t map_size = checkSize( write, file, filename, len ); // get the mapping size
 
-	if( map_size ) {
-		m_good = map( file, map_size, write, filename ); //and do the mapping
+	if( mode == read_default )
+		mode = getDefaultReadMode();
+
+	if( map_size && !write && mode != read_mmap ) {
+		m_good = read( file, map_size, filename, mode, hints ); //read the whole file
+		LOG( Debug, info ) << "Read " << map_size << " bytes of " << util::MSubject( filename ) << " into " << getRawAddress().get();
+#ifdef WIN32
+		if( !m_good ) CloseHandle( file );
+#else
+		::close( file ); // we don't need the file anymore (if it was mapped instead, the mapping closes it)
+#endif
+	} else if( map_size ) {
+		m_good = map( file, map_size, write, filename, hints ); //and do the mapping
 		LOG( Debug, info ) << "Mapped " << map_size << " bytes of " << util::MSubject( filename ) << " at " << getRawAddress().get();
 	}
 
 	// from here on the pointer will be set if mapping succeded
 }
 
+FilePtr::FilePtr( const ValueArray<uint8_t> &memory ): ValueArray<uint8_t>( memory ), m_good( memory.getLength() > 0 ), writing( false ) {}
+
+bool FilePtr::advise( int hints, size_t offset, size_t len )
+{
+	uint8_t *const data = static_cast<boost::shared_ptr<uint8_t>&>( *this ).get();
+
+	if( len == 0 && offset < getLength() )
+		len = getLength() - offset;
+
+	if( data == 0 || len == 0 || offset + len > getLength() ) {
+		LOG( Debug, error ) << "Cannot advise the range [" << offset << "," << offset + len << ") of a mapping of " << getLength() << " bytes";
+		return false;
+	}
+
+	LOG_IF( ( hints & access_sequential ) && ( hints & access_random ), Debug, warning )
+			<< "access_sequential and access_random exclude each other, using access_random";
+
+	// the start of the range has to be moved to the start of its page (memory which was not mapped might not start at a page, madvise will refuse that then)
+	const size_t pagesize = _internal::getPageSize();
+	const size_t misalign = std::min<size_t>( reinterpret_cast<size_t>( data + offset ) % pagesize, offset );
+	uint8_t *const at = data + offset - misalign;
+	len += misalign;
+	bool ok = true;
+
+#ifdef WIN32
+	LOG_IF( hints & ~access_populate, Debug, info ) << "Access hints are not supported on this platform, ignoring them";
+#else
+	const int pattern = ( hints & access_random ) ? MADV_RANDOM : ( ( hints & access_sequential ) ? MADV_SEQUENTIAL : MADV_NORMAL );
+	ok = _internal::adviseRange( at, len, pattern, "the access pattern" );
+
+	if( hints & access_willneed )
+		ok = _internal::adviseRange( at, len, MADV_WILLNEED, "MADV_WILLNEED" ) && ok;
+
+	if( hints & access_hugepages ) {
+#ifdef MADV_HUGEPAGE
+		ok = _internal::adviseRange( at, len, MADV_HUGEPAGE, "MADV_HUGEPAGE" ) && ok;
+#else
+		LOG( Debug, info ) << "Huge pages are not supported on this platform, ignoring the hint";
+#endif
+	}
+
+#endif
+
+	if( hints & access_populate ) {
+#ifdef MADV_POPULATE_READ
+
+		if( !_internal::adviseRange( at, len, MADV_POPULATE_READ, "MADV_POPULATE_READ" ) ) // older kernels don't know it
+#endif
+			_internal::touchPages( at, len, pagesize );
+	}
+
+	return ok;
+}
+
 bool FilePtr::good() {return m_good;}
 
 void FilePtr::release()
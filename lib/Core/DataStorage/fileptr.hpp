@@ -34,9 +34,36 @@ namespace data
  *
  * This is inherting from ValueArray. Thus this, and all ValueArray created from it will be managed.
  * The mapped file will automatically unmapped and closed after all pointers a deleted.
+ *
+ * The operating system can be told how the mapped file is going to be read (see accessHint), so it can read ahead and map pages accordingly.
+ * Loaders should set the hints that fit the way they read the file.
+ *
+ * Files opened for reading can also be read into memory at once instead of being mapped (see readMode).
+ * This is selected per FilePtr or for all of them (see setDefaultReadMode), the interface stays the same.
  */
 class FilePtr: public ValueArray<uint8_t>
 {
+public:
+	/**
+	 * Hints how the mapped file is going to be accessed.
+	 * They can be combined (except access_sequential and access_random) and are ignored where the operating system does not support them.
+	 */
+	enum accessHint {
+		access_normal = 0,     ///< no special treatment (the default read ahead)
+		access_sequential = 1, ///< the data will be read from the start to the end (aggressive read ahead, pages can be dropped soon after they were read)
+		access_random = 2,     ///< the data will be read in random order (no read ahead)
+		access_willneed = 4,   ///< the data will be needed soon (start reading them in the background)
+		access_populate = 8,   ///< read the data and map all pages at once (no page faults later, but it blocks until everything is read)
+		access_hugepages = 16  ///< back the mapping with transparent huge pages (fewer page faults and TLB misses, if the system supports it for files)
+	};
+	/// How files opened for reading are brought into memory (files opened for writing are always mapped).
+	enum readMode {
+		read_default = 0, ///< use the default mode (see getDefaultReadMode)
+		read_mmap,        ///< map the file, pages are read from the file when they are accessed first
+		read_pread,       ///< read the whole file into memory at once, using big blocks which are read in parallel
+		read_direct       ///< like read_pread, but bypass the page cache (O_DIRECT), falls back to read_pread if the filesystem does not support it
+	};
+private:
 	struct Closer {
 		FILE_HANDLE file, mmaph;
 		size_t len;
@@ -59,7 +86,8 @@ class FilePtr: public ValueArray<uint8_t>
 		};
 	};
 
-	bool map( FILE_HANDLE file, size_t len, bool write, const boost::filesystem::path &filename );
+	bool map( FILE_HANDLE file, size_t len, bool write, const boost::filesystem::path &filename, int hints );
+	bool read( FILE_HANDLE file, size_t len, const boost::filesystem::path &filename, readMode mode, int hints );
 
 	size_t checkSize( bool write, FILE_HANDLE file, const boost::filesystem::path &filename, size_t size = 0 );
 	bool m_good, writing;
@@ -85,8 +113,25 @@ public:
 	 * \param filename the file to map into memory
 	 * \param len the requested length of the resulting ValueArray in bytes (automatically set if 0)
 	 * \param write the file be opened for writing (writing to the mapped memory will write to the file, otherwise it will cause a copy-on-write)
+	 * \param hints how the file is going to be accessed (combination of accessHint)
+	 * \param mode how the file is brought into memory if it is opened for reading
+	 */
+	FilePtr( const boost::filesystem::path &filename, size_t len = 0, bool write = false, int hints = access_normal, readMode mode = read_default );
+
+	/**
+	 * Create a FilePtr for data which already are in memory (e.g. a decompressed file).
+	 * It behaves like a file opened for reading, so loaders can read files and memory the same way.
+	 * \param memory the content of the "file" (it is not copied, the FilePtr and all ValueArray created from it share it)
+	 */
+	explicit FilePtr( const ValueArray<uint8_t> &memory );
+
+	/**
+	 * Set the readMode used for files opened for reading if no mode is given explicitly.
+	 * Initially this is read from the environment variable ISIS_FILE_READ ("mmap", "pread" or "direct"), and read_mmap if that is not set.
 	 */
-	FilePtr( const boost::filesystem::path &filename, size_t len = 0, bool write = false );
+	static void setDefaultReadMode( readMode mode );
+	/// \returns the readMode used for files opened for reading if no mode is given explicitly
+	static readMode getDefaultReadMode();
 
 	/**
 	 * Get a ValueArray representing the data in the file.
@@ -144,6 +189,17 @@ public:
 	 */
 	data::ValueArrayReference atByID( unsigned short ID, size_t offset, size_t len = 0, bool swap_endianess = false );
 
+	/**
+	 * Tell the operating system how a part of the mapped file is going to be accessed.
+	 * This replaces the hints given before for that part.
+	 * E.g. a loader can ask for the voxel data to be read in the background once it parsed the header.
+	 * \param hints how the data are going to be accessed (combination of accessHint)
+	 * \param offset the position in the file where the part starts (in bytes)
+	 * \param len the length of the part in bytes (till the end of the file if 0)
+	 * \returns false if the part is not inside the mapped file or the operating system refused the hints
+	 */
+	bool advise( int hints, size_t offset = 0, size_t len = 0 );
+
 	bool good();
 	void release();
 };
@@ -20,6 +20,7 @@
 #include "../CoreUtils/vector.hpp"
 #include <boost/foreach.hpp>
 #include "../CoreUtils/property.hpp"
+#include "../CoreUtils/threadpool.hpp"
 #include <boost/token_iterator.hpp>
 
 #define _USE_MATH_DEFINES 1
@@ -105,21 +106,71 @@ bool Image::isClean()const
 	return clean;
 }
 
+/// @cond _internal
+namespace _internal
+{
+// collects the properties which are common in a range of chunks, and the ones which are not (see Image::deduplicateProperties)
+struct ChunkCommonProps {
+	const boost::shared_ptr<Chunk> *chunks;
+	util::PropertyMap *commons;
+	util::PropertyMap::KeyList *uniques;
+	void operator()( size_t block, size_t start, size_t end )const {
+		commons[block] = *chunks[start];
+
+		for( size_t i = start + 1; i < end; i++ )
+			chunks[i]->toCommonUnique( commons[block], uniques[block], false );
+	}
+};
+// merges the common/unique properties of another range of chunks into these of the first one
+void mergeCommonProps( util::PropertyMap &common, util::PropertyMap::KeyList &uniques, const util::PropertyMap &otherCommon, const util::PropertyMap::KeyList &otherUniques )
+{
+	uniques.insert( otherUniques.begin(), otherUniques.end() );
+	otherCommon.toCommonUnique( common, uniques, false );
+}
+// removes the common properties from a range of chunks
+struct ChunkRemoveProps {
+	const boost::shared_ptr<Chunk> *chunks;
+	const util::PropertyMap *common;
+	void operator()( size_t /*block*/, size_t start, size_t end )const {
+		for( size_t i = start; i < end; i++ )
+			chunks[i]->remove( *common, false );
+	}
+};
+}
+/// @endcond
+
 void Image::deduplicateProperties()
 {
-	LOG_IF( lookup.empty(), Debug, error ) << "The lookup table is empty. Won't do anything.";
-	const boost::shared_ptr<Chunk> &first = lookup[0];
+	if( lookup.empty() ) {
+		LOG( Debug, error ) << "The lookup table is empty. Won't do anything.";
+		return;
+	}
+
 	//@todo might fail if the image contains a prop that differs to that in the Chunks (which is equal in the chunks)
-	util::PropertyMap common=*first;;
-	util::PropertyMap::KeyList uniques;
+	util::ThreadPool &pool = util::ThreadPool::global();
+
+	// find the common properties of blocks of chunks in parallel ...
+	const size_t blocks = pool.getBlocks( lookup.size(), 32 );
+	std::vector<util::PropertyMap> commons( blocks );
+	std::vector<util::PropertyMap::KeyList> uniques( blocks );
+	const _internal::ChunkCommonProps collect = {&lookup[0], &commons[0], &uniques[0]};
+	pool.forEachBlock( lookup.size(), 32, collect );
+
+	// ... and merge them pairwise until only the first one is left
+	for( size_t step = 1; step < blocks; step *= 2 ) {
+		std::vector<util::ThreadPool::job> jobs;
 
-	for ( size_t i = 1; i < lookup.size(); i++ ) {
-		lookup[i]->toCommonUnique( common, uniques, false );
+		for( size_t b = 0; b + step < blocks; b += 2 * step )
+			jobs.push_back( boost::bind( _internal::mergeCommonProps, boost::ref( commons[b] ), boost::ref( uniques[b] ), boost::cref( commons[b + step] ), boost::cref( uniques[b + step] ) ) );
+
+		pool.run( jobs );
 	}
 
+	util::PropertyMap &common = commons[0];
+
 	// @todo removing uniques - list might improve performance
-	LOG( Debug, info ) << uniques.size() << " Chunk-unique properties found in the Image";
-	LOG_IF( uniques.size(), Debug, verbose_info ) << util::listToString( uniques.begin(), uniques.end(), ", " );
+	LOG( Debug, info ) << uniques[0].size() << " Chunk-unique properties found in the Image";
+	LOG_IF( uniques[0].size(), Debug, verbose_info ) << util::listToString( uniques[0].begin(), uniques[0].end(), ", " );
 
 	// list should not be unified - they belong into their chunk even if they are common
 	common.remove( common.findLists() );
@@ -128,8 +179,8 @@ void Image::deduplicateProperties()
 	LOG_IF( ! common.isEmpty(), Debug, verbose_info ) << "common properties saved into the image " << common;
 
 	//remove common props from the chunks
-	for ( size_t i = 0; i != lookup.size(); i++ )
-		lookup[i]->remove( common, false ); //this _won't keep needed properties - so from here on the chunks of the image are invalid
+	const _internal::ChunkRemoveProps strip = {&lookup[0], &common};
+	pool.forEachBlock( lookup.size(), 32, strip ); //this _won't keep needed properties - so from here on the chunks of the image are invalid
 
 	LOG_IF( ! common.isEmpty(), Debug, verbose_info ) << "common properties removed from " << lookup.size() << " chunks: " << common;
 
@@ -173,6 +224,27 @@ bool Image::insertChunk ( const Chunk &chunk )
 	}
 }
 
+std::list<std::list<Chunk> > Image::groupChunks( std::list<Chunk> &chunks )
+{
+	const _internal::SortedChunkList probe( defaultChunkEqualitySet );
+	std::map<size_t, std::list<Chunk>*> groups; // collisions only merge groups, Image will sort them out while inserting
+	std::list<std::list<Chunk> > ret;
+
+	while( !chunks.empty() ) {
+		std::list<Chunk> *&group = groups[probe.getEqualityHash( chunks.front() )];
+
+		if( !group ) {
+			ret.push_back( std::list<Chunk>() );
+			group = &ret.back();
+		}
+
+		group->splice( group->end(), chunks, chunks.begin() );
+	}
+
+	LOG( Debug, info ) << "Split chunks into " << ret.size() << " groups";
+	return ret;
+}
+
 void Image::setIndexingDim( dimensions d )
 {
 	minIndexingDim = d;
@@ -289,9 +361,14 @@ bool Image::transformCoords( boost::numeric::ublas::matrix< float > transform_ma
 
 	BOOST_FOREACH ( std::vector<boost::shared_ptr< data::Chunk> >::reference chRef, lookup ) {
 		if ( !chRef->transformCoords ( transform_matrix, transformCenterIsImageCenter ) ) {
+			set.updateGeometry(); // some of the chunks were moved already
 			return false;
 		}
+	}
+
+	set.updateGeometry(); // the chunks were moved, so the geometry the set got when they were inserted is wrong now (needs the propagated properties)
 
+	BOOST_FOREACH ( std::vector<boost::shared_ptr< data::Chunk> >::reference chRef, lookup ) {
 		BOOST_FOREACH( std::list<PropPath>::const_reference pPathNotNeeded, propPathList ) {
 			chRef->remove( pPathNotNeeded );
 		}
@@ -431,56 +508,52 @@ bool Image::reIndex()
 
 
 	//if we have at least two slides (and have slides (with different positions) at all)
-	if ( chunk_dims == 2 && structure_size[2] > 1 && first.hasProperty( "indexOrigin" ) ) {
-		const util::fvector3 firstV = first.getPropertyAs<util::fvector3>( "indexOrigin" );
-		const Chunk &last = chunkAt( structure_size[2] - 1 );
-
-		if ( last.hasProperty( "indexOrigin" ) ) {
-			const util::fvector3 lastV = last.getPropertyAs<util::fvector3>( "indexOrigin" );
-			//check the slice vector
-			util::fvector3 distVecNorm = lastV - firstV;
-			LOG_IF( distVecNorm.len() == 0, Runtime, error )
-					<< "The distance between the the first and the last chunk is zero. Thats bad, because I'm going to normalize it.";
-			distVecNorm.norm();
-
-			if ( hasProperty( "sliceVec" ) ) {
-				const util::fvector3 sliceVec = getPropertyAs<util::fvector3>( "sliceVec" );
-				LOG_IF( ! distVecNorm.fuzzyEqual( sliceVec ), Runtime, info )
-						<< "The existing sliceVec " << sliceVec
-						<< " differs from the distance vector between chunk 0 and " << structure_size[2] - 1
-						<< " " << distVecNorm;
-			} else {
-				LOG( Debug, info )
-						<< "used the distance between chunk 0 and " << structure_size[2] - 1
-						<< " to synthesize the missing sliceVec as " << distVecNorm;
-				propertyValue( "sliceVec" ) = distVecNorm;
-			}
+	const std::vector<_internal::SortedChunkList::ChunkGeometry> &geometry = set.getGeometryLookup();
+
+	if ( chunk_dims == 2 && structure_size[2] > 1 && geometry.size() > timesteps ) { // more geometry entries than timesteps means more than one position
+		const util::fvector3 &firstV = geometry[0].indexOrigin;
+		const util::fvector3 &lastV = geometry[structure_size[2] - 1].indexOrigin;
+
+		//check the slice vector
+		util::fvector3 distVecNorm = lastV - firstV;
+		LOG_IF( distVecNorm.len() == 0, Runtime, error )
+				<< "The distance between the the first and the last chunk is zero. Thats bad, because I'm going to normalize it.";
+		distVecNorm.norm();
+
+		if ( hasProperty( "sliceVec" ) ) {
+			const util::fvector3 sliceVec = getPropertyAs<util::fvector3>( "sliceVec" );
+			LOG_IF( ! distVecNorm.fuzzyEqual( sliceVec ), Runtime, info )
+					<< "The existing sliceVec " << sliceVec
+					<< " differs from the distance vector between chunk 0 and " << structure_size[2] - 1
+					<< " " << distVecNorm;
+		} else {
+			LOG( Debug, info )
+					<< "used the distance between chunk 0 and " << structure_size[2] - 1
+					<< " to synthesize the missing sliceVec as " << distVecNorm;
+			propertyValue( "sliceVec" ) = distVecNorm;
 		}
 
-		if ( last.hasProperty( "indexOrigin" ) ) {
-			const util::fvector3 lastV = last.getPropertyAs<util::fvector3>( "indexOrigin" );
-			const float avDist = ( lastV - firstV ).len() / (structure_size[2]-1); //average dist between the middle of two slices
-			const float sliceDist = avDist - voxeSize[2]; // the gap between two slices
+		const float avDist = ( lastV - firstV ).len() / (structure_size[2]-1); //average dist between the middle of two slices
+		const float sliceDist = avDist - voxeSize[2]; // the gap between two slices
 
-			if ( sliceDist > 0 ) {
-				static const float inf = std::numeric_limits<float>::infinity();
+		if ( sliceDist > 0 ) {
+			static const float inf = std::numeric_limits<float>::infinity();
 
-				if ( ! hasProperty( "voxelGap" ) ) { // @todo check this
-					setPropertyAs( "voxelGap", util::fvector3( 0, 0, inf ) );
-				}
+			if ( ! hasProperty( "voxelGap" ) ) { // @todo check this
+				setPropertyAs( "voxelGap", util::fvector3( 0, 0, inf ) );
+			}
 
-				util::fvector3 &voxelGap = propertyValue( "voxelGap" ).castTo<util::fvector3>(); //if there is no voxelGap yet, we create it
+			util::fvector3 &voxelGap = propertyValue( "voxelGap" ).castTo<util::fvector3>(); //if there is no voxelGap yet, we create it
 
-				if ( voxelGap[2] != inf ) {
-					LOG_IF( ! util::fuzzyEqual( voxelGap[2], sliceDist, 20 ), Runtime, warning )
-							<< "The existing slice distance (voxelGap[2]) " << util::MSubject( voxelGap[2] )
-							<< " differs from the distance between chunk 0 and 1, which is " << sliceDist;
-				} else {
-					voxelGap[2] = sliceDist;
-					LOG( Debug, info )
-							<< "used the distance between chunk 0 and 1 to synthesize the missing slice distance (voxelGap[2]) as "
-							<< sliceDist;
-				}
+			if ( voxelGap[2] != inf ) {
+				LOG_IF( ! util::fuzzyEqual( voxelGap[2], sliceDist, 20 ), Runtime, warning )
+						<< "The existing slice distance (voxelGap[2]) " << util::MSubject( voxelGap[2] )
+						<< " differs from the distance between chunk 0 and 1, which is " << sliceDist;
+			} else {
+				voxelGap[2] = sliceDist;
+				LOG( Debug, info )
+						<< "used the distance between chunk 0 and 1 to synthesize the missing slice distance (voxelGap[2]) as "
+						<< sliceDist;
 			}
 		}
 	}
@@ -693,8 +766,9 @@ size_t Image::getChunkStride ( size_t base_stride )
 		 * |c c| is the first reasonable case
 		 */
 		// get the distance between first and second chunk for comparision
-		const util::fvector3 firstV = chunkAt( 0 ).getPropertyAs<util::fvector3>( "indexOrigin" );
-		const util::fvector3 secondV = chunkAt( base_stride ).getPropertyAs<util::fvector3>( "indexOrigin" );
+		const std::vector<_internal::SortedChunkList::ChunkGeometry> &geometry = set.getGeometryLookup();
+		const util::fvector3 &firstV = geometry[0].indexOrigin;
+		const util::fvector3 &secondV = geometry[base_stride].indexOrigin;
 		const util::fvector3 dist1 = secondV - firstV;
 
 		if( dist1.sqlen() == 0 ) { //if there is no geometric structure anymore - so asume its flat from here on
@@ -702,8 +776,8 @@ size_t Image::getChunkStride ( size_t base_stride )
 							   << " is zero. Assuming there are no dimensional breaks anymore. Returning " << util::MSubject( base_stride );
 			return base_stride;
 		} else for ( size_t i = base_stride; i < lookup.size() - base_stride; i += base_stride ) {  // compare every follwing distance to that
-				const util::fvector3 thisV = chunkAt( i ).getPropertyAs<util::fvector3>( "indexOrigin" );
-				const util::fvector3 nextV = chunkAt( i + base_stride ).getPropertyAs<util::fvector3>( "indexOrigin" );
+				const util::fvector3 &thisV = geometry[i].indexOrigin;
+				const util::fvector3 &nextV = geometry[i + base_stride].indexOrigin;
 				const util::fvector3 distFirst = nextV - firstV;
 				const util::fvector3 distThis = nextV - thisV;
 				LOG( Debug, verbose_info )
@@ -771,22 +845,40 @@ size_t Image::getMaxBytesPerVoxel() const
 	return bytes;
 }
 
+/// @cond _internal
+namespace _internal
+{
+// computes the min/max of a range of chunks (see Image::getMinMax)
+struct ChunkMinMax {
+	const boost::shared_ptr<Chunk> *chunks;
+	std::pair<util::ValueReference, util::ValueReference> *results;
+	void operator()( size_t /*block*/, size_t start, size_t end )const {
+		for( size_t i = start; i < end; i++ )
+			results[i] = chunks[i]->getMinMax();
+	}
+};
+}
+/// @endcond
+
 std::pair<util::ValueReference, util::ValueReference> Image::getMinMax () const
 {
 	std::pair<util::ValueReference, util::ValueReference> ret;
 
 	if( !lookup.empty() ) {
-		std::vector<boost::shared_ptr<Chunk> >::const_iterator i = lookup.begin();
-		ret = ( *i )->getMinMax();
+		// get the min/max of the chunks in parallel, and then the min/max of those
+		std::vector<std::pair<util::ValueReference, util::ValueReference> > minmax( lookup.size() );
+		const _internal::ChunkMinMax op = {&lookup[0], &minmax[0]};
+		util::ThreadPool::global().forEachBlock( lookup.size(), 1, op );
 
-		for( ++i; i != lookup.end(); ++i ) {
-			std::pair<util::ValueReference, util::ValueReference> current = ( *i )->getMinMax();
+		std::vector<std::pair<util::ValueReference, util::ValueReference> >::const_iterator i = minmax.begin();
+		ret = *i;
 
-			if( ret.first->gt( *current.first ) )
-				ret.first = current.first;
+		for( ++i; i != minmax.end(); ++i ) {
+			if( ret.first->gt( *i->first ) )
+				ret.first = i->first;
 
-			if( ret.second->lt( *current.second ) )
-				ret.second = current.second;
+			if( ret.second->lt( *i->second ) )
+				ret.second = i->second;
 		}
 	}
 
@@ -812,37 +904,69 @@ std::pair< util::ValueReference, util::ValueReference > Image::getScalingTo( sho
 		   );
 }
 
+/// @cond _internal
+namespace _internal
+{
+// compares a range of segments of two images, a segment never crosses the border of a chunk in any of both (see Image::compare)
+struct ImageCompareBlock {
+	const boost::shared_ptr<Chunk> *chunks, *comp_chunks;
+	size_t volume, comp_volume, segment;
+	compareMode mode;
+	double tolerance;
+	bool stopAtFirst;
+	CompareResult *results;
+	void operator()( size_t block, size_t start, size_t end )const {
+		for( size_t s = start; s < end && !( stopAtFirst && results[block].different ); s++ ) {
+			const size_t i = s * segment;
+			const ValueArrayBase &data = chunks[i / volume]->getValueArrayBase(), &comp_data = comp_chunks[i / comp_volume]->getValueArrayBase();
+			results[block] += data.compare( i % volume, i % volume + segment, comp_data, i % comp_volume, mode, tolerance, stopAtFirst );
+		}
+	}
+};
+}
+/// @endcond
+
 size_t Image::compare( const isis::data::Image &comp ) const
 {
-	size_t ret = 0;
+	return compare( comp, compare_exact ).different;
+}
+
+CompareResult Image::compare( const Image &comp, compareMode mode, double tolerance, bool stopAtFirst ) const
+{
+	CompareResult ret;
 	LOG_IF( ! ( clean && comp.clean ), Debug, error )
 			<< "Comparing unindexed images will cause you trouble, run reIndex()!";
 
 	if ( getSizeAsVector() != comp.getSizeAsVector() ) {
 		LOG( Runtime, warning ) << "Size of images differs (" << getSizeAsVector() << "/"
-								<< comp.getSizeAsVector() << "). Adding difference to the result.";
-		ret += ( getSizeAsVector() - comp.getSizeAsVector() ).product();
+								<< comp.getSizeAsVector() << "). Assuming all voxels to be different.";
+		ret.compared = ret.different = std::max( getVolume(), comp.getVolume() );
+		return ret;
 	}
 
-	util::ivector4 compVect( util::minVector( chunkPtrAt( 0 )->getSizeAsVector(), comp.chunkPtrAt( 0 )->getSizeAsVector() ) );
-	util::ivector4 start;
-	const size_t increment = compVect.product();
-
-	for ( size_t i = 0; i < getVolume(); i += increment ) {
-		const size_t nexti = i + increment - 1;
-		const std::pair<size_t, size_t> c1pair1( i / chunkVolume, i % chunkVolume );
-		const std::pair<size_t, size_t> c1pair2( nexti / chunkVolume, nexti % chunkVolume );
-		const std::pair<size_t, size_t> c2pair1( i / comp.chunkVolume, i % comp.chunkVolume );
-		assert( c1pair1.first == c1pair2.first );
-		LOG( Debug, verbose_info ) << "Comparing chunks at " << c1pair1.first << " and "   << c2pair1.first;
-		const Chunk &c1 = *chunkPtrAt( c1pair1.first );
-		const Chunk &c2 = *( comp.chunkPtrAt( c2pair1.first ) );
-		LOG( Debug, verbose_info )
-				<< "Start positions are " << c1pair1.second << " and " << c2pair1.second
-				<< " and the length is " << c1pair2.second - c1pair1.second;
-		ret += c1.getValueArrayBase().compare( c1pair1.second, c1pair2.second, c2.getValueArrayBase(), c2pair1.second );
+	if( getVolume() == 0 || lookup.empty() || comp.lookup.empty() ) // nothing to compare (and no chunks to get a segment from)
+		return ret;
+
+	// the biggest segment which fits into the chunks of both images (the greatest common divisor of their volumes)
+	size_t segment = chunkVolume;
+
+	for( size_t rest = comp.chunkVolume; rest; ) {
+		const size_t next = segment % rest;
+		segment = rest;
+		rest = next;
 	}
 
+	const size_t segments = getVolume() / segment, min_block = std::max<size_t>( ( 64 * 1024 ) / segment, 1 );
+	LOG( Debug, verbose_info ) << "Comparing " << segments << " segments of " << segment << " voxels";
+
+	util::ThreadPool &pool = util::ThreadPool::global();
+	std::vector<CompareResult> results( pool.getBlocks( segments, min_block ) );
+	const _internal::ImageCompareBlock op = {&lookup[0], &comp.lookup[0], chunkVolume, comp.chunkVolume, segment, mode, tolerance, stopAtFirst, &results[0]};
+	pool.forEachBlock( segments, min_block, op );
+
+	for( std::vector<CompareResult>::const_iterator i = results.begin(); i != results.end() && !( stopAtFirst && ret.different ); ++i )
+		ret += *i;
+
 	return ret;
 }
 
@@ -1080,12 +1204,7 @@ util::fvector3 Image::getFoV() const
 Image::iterator Image::begin()
 {
 	if( checkMakeClean() ) {
-		std::vector<Chunk *> vec( lookup.size() );
-
-		for( size_t i = 0; i < lookup.size(); i++ )
-			vec[i] = lookup[i].get();
-
-		return iterator( vec );
+		return iterator( lookup );
 	} else {
 		LOG( Debug, error )  << "Image is not clean. Returning empty iterator ...";
 		return iterator();
@@ -1095,12 +1214,7 @@ Image::iterator Image::end() {return begin() + getVolume();}
 Image::const_iterator Image::begin()const
 {
 	if( isClean() ) {
-		std::vector<const Chunk *> vec( lookup.size() );
-
-		for( size_t i = 0; i < lookup.size(); i++ )
-			vec[i] = lookup[i].get();
-
-		return const_iterator( vec );
+		return const_iterator( lookup );
 	} else {
 		LOG( Debug, error )  << "Image is not clean. Returning empty iterator ...";
 		return const_iterator();
@@ -23,8 +23,10 @@
 #include <boost/numeric/ublas/io.hpp>
 #include <boost/type_traits/remove_const.hpp>
 #include <stack>
+#include <numeric>
 #include "sortedchunklist.hpp"
 #include "common.hpp"
+#include "../CoreUtils/threadpool.hpp"
 
 namespace isis
 {
@@ -32,11 +34,19 @@ namespace data
 {
 namespace _internal
 {
+/// get the part of a chunk an ImageIteratorTemplate iterates over (the chunk itself, or its typed ValueArray)
+inline Chunk &imageSegment( Chunk &ch, const Chunk * ) {return ch;}
+template<typename T> ValueArray<T> &imageSegment( Chunk &ch, const ValueArray<T> * ) {return ch.asValueArray<T>();}
+
 /**
  * Generic iterator for voxels in Images.
  * It automatically jumps from chunk to Chunk.
  * It needs the chunks and the image to be there for to work properly (so don't delete the image, and dont reIndex it),
  * It assumes that all Chunks have the same size (which is a rule for Image as well, so this should be given)
+ *
+ * The iterator is segmented: it holds an iterator into the current chunk and only looks at the chunk list when it leaves that chunk.
+ * So ++ and -- are an increment of the inner iterator and a check for the end of the chunk.
+ * Algorithms which can work on contiguous memory should use local(), localEnd() and nextSegment() to process whole chunks at once.
  */
 template<typename CHUNK_TYPE> class ImageIteratorTemplate: public std::iterator <
 	std::random_access_iterator_tag,
@@ -46,50 +56,72 @@ template<typename CHUNK_TYPE> class ImageIteratorTemplate: public std::iterator
 	typename boost::mpl::if_<boost::is_const<CHUNK_TYPE>, typename CHUNK_TYPE::const_iterator, typename CHUNK_TYPE::iterator>::type::reference
 	>
 {
-protected:
+public:
 	typedef typename boost::mpl::if_<boost::is_const<CHUNK_TYPE>, typename CHUNK_TYPE::const_iterator, typename CHUNK_TYPE::iterator>::type inner_iterator;
+protected:
 	typedef CHUNK_TYPE chunk_type;
 	typedef ImageIteratorTemplate<CHUNK_TYPE> ThisType;
 
-	std::vector<chunk_type *> chunks;
-	size_t ch_idx;
-	inner_iterator current_it;
+	const boost::shared_ptr<Chunk> *chunks;
+	size_t ch_cnt, ch_idx; // behind the last chunk ch_idx is ch_cnt, the segment stays the last chunk then
+	inner_iterator current_it, seg_begin, seg_end;
 	typename inner_iterator::difference_type ch_len;
 
+	void setSegment( size_t idx ) {
+		chunk_type &seg = imageSegment( *chunks[idx], static_cast<chunk_type *>( NULL ) );
+		ch_idx = idx;
+		seg_begin = seg.begin();
+		seg_end = seg.end();
+	}
 	typename inner_iterator::difference_type currentDist() const {
-		if ( ch_idx >= chunks.size() )
+		if ( ch_idx >= ch_cnt )
 			return 0; // if we're behind the last chunk assume we are at the "start" of the "end"-chunk
-		else {
-			const inner_iterator chit_begin = chunks[ch_idx]->begin(); // cast in a const or cast out a non existing one
-			return std::distance ( chit_begin, current_it ); // so we use same iterators here
-		}
+		else
+			return current_it - seg_begin;
 	}
 	friend class ImageIteratorTemplate<const CHUNK_TYPE>; //yes, I'm my own friend, sometimes :-) (enables the constructor below)
 public:
 
 	//will become additional constructor from non const if this is const, otherwise overrride the default copy contructor
 	ImageIteratorTemplate ( const ImageIteratorTemplate<typename boost::remove_const<CHUNK_TYPE>::type > &src ) :
-		chunks ( src.chunks.begin(), src.chunks.end() ), ch_idx ( src.ch_idx ),
-		current_it ( src.current_it ),
+		chunks ( src.chunks ), ch_cnt ( src.ch_cnt ), ch_idx ( src.ch_idx ),
+		current_it ( src.current_it ), seg_begin ( src.seg_begin ), seg_end ( src.seg_end ),
 		ch_len ( src.ch_len )
 	{}
 
 	// empty constructor
-	ImageIteratorTemplate() : ch_idx ( 0 ), ch_len ( 0 ) {}
+	ImageIteratorTemplate() : chunks ( NULL ), ch_cnt ( 0 ), ch_idx ( 0 ), ch_len ( 0 ) {}
 
 
-	// normal conytructor
-	explicit ImageIteratorTemplate ( const std::vector<chunk_type *>& _chunks ) :
-		chunks ( _chunks ), ch_idx ( 0 ),
-		current_it ( chunks[0]->begin() ),
-		ch_len ( std::distance ( current_it, chunks[0]->end() ) )
-	{}
+	// normal conytructor (the chunks are not copied, so the list must stay as it is while the iterator is used)
+	explicit ImageIteratorTemplate ( const std::vector<boost::shared_ptr<Chunk> > &_chunks ) :
+		chunks ( &_chunks[0] ), ch_cnt ( _chunks.size() ) {
+		setSegment( 0 );
+		current_it = seg_begin;
+		ch_len = seg_end - seg_begin;
+	}
 
 	ThisType &operator++() {
-		return operator+= ( 1 );
+		if ( ++current_it == seg_end ) { // we left the chunk
+			if ( ch_idx + 1 < ch_cnt ) { // hop into the next one
+				setSegment( ch_idx + 1 );
+				current_it = seg_begin;
+			} else // the end of the last chunk is the end of the image
+				ch_idx = ch_cnt;
+		}
+
+		return *this;
 	}
 	ThisType &operator--() {
-		return operator-= ( 1 );
+		if ( ch_idx >= ch_cnt ) { // go back from the end of the image into the last chunk
+			ch_idx = ch_cnt - 1;
+		} else if ( current_it == seg_begin ) { // hop to the end of the previous chunk
+			setSegment( ch_idx - 1 );
+			current_it = seg_end;
+		}
+
+		--current_it;
+		return *this;
 	}
 
 	ThisType operator++ ( int ) {
@@ -133,15 +165,9 @@ public:
 	}
 
 	typename inner_iterator::difference_type operator- ( const ThisType &cmp ) const {
-		typename inner_iterator::difference_type dist = ( ch_idx - cmp.ch_idx ) * ch_len; // get the (virtual) distance from my current block to cmp's current block
-
-		if ( ch_idx >= cmp.ch_idx ) { //if I'm beyond cmp add my current pos to the distance, and substract his
-			dist += currentDist() - cmp.currentDist();
-		} else {
-			dist += cmp.currentDist() - currentDist();
-		}
-
-		return dist;
+		// the (virtual) distance from cmp's current block to my current block plus the positions inside of these blocks
+		return ( static_cast<typename ThisType::difference_type>( ch_idx ) - static_cast<typename ThisType::difference_type>( cmp.ch_idx ) ) * ch_len
+			   + currentDist() - cmp.currentDist();
 	}
 
 	ThisType operator+ ( typename ThisType::difference_type n ) const {
@@ -153,13 +179,28 @@ public:
 
 	ThisType &operator+= ( typename inner_iterator::difference_type n ) {
 		n += currentDist(); //start from current begin (add current_it-(begin of the current chunk) to n)
-		assert ( ( n / ch_len + static_cast<typename ThisType::difference_type> ( ch_idx ) ) >= 0 );
-		ch_idx += n / ch_len; //if neccesary jump to next chunk
 
-		if ( ch_idx < chunks.size() )
-			current_it = chunks[ch_idx]->begin() + n % ch_len; //set new current iterator in new chunk plus the "rest"
-		else
-			current_it = ( * ( chunks.end() - 1 ) )->end() ; //set current_it to the last chunks end iterator if we are behind it
+		if ( ch_idx < ch_cnt && n >= 0 && n < ch_len ) { // we stay in the current chunk
+			current_it = seg_begin + n;
+			return *this;
+		}
+
+		const typename inner_iterator::difference_type hops = n >= 0 ? n / ch_len : -( ( ch_len - 1 - n ) / ch_len ); // round down, even if we go back
+		assert ( ( hops + static_cast<typename ThisType::difference_type> ( ch_idx ) ) >= 0 );
+		const size_t idx = ch_idx + hops;
+
+		if ( idx < ch_cnt ) {
+			if ( idx != ch_idx ) //if neccesary jump to the other chunk
+				setSegment( idx );
+
+			current_it = seg_begin + ( n - hops * ch_len ); //set new current iterator in new chunk plus the "rest"
+		} else { //set current_it to the last chunks end iterator if we are behind it
+			if ( ch_idx + 1 < ch_cnt )
+				setSegment( ch_cnt - 1 );
+
+			ch_idx = ch_cnt;
+			current_it = seg_end;
+		}
 
 		return *this;
 	}
@@ -168,7 +209,35 @@ public:
 	}
 
 	typename ThisType::reference operator[] ( typename inner_iterator::difference_type n ) const {
-		return * ( ThisType ( chunks ) += n );
+		ThisType ret ( *this );
+		ret.setSegment( 0 );
+		ret.current_it = ret.seg_begin;
+		return * ( ret += n );
+	}
+
+	/// \returns the iterator into the current chunk
+	inner_iterator local() const {
+		return current_it;
+	}
+	/**
+	 * Get the end of the current chunk.
+	 * The voxels in [local(),localEnd()) are contiguous, so they can be processed at once.
+	 * Note that this is the end of the chunk, not of a range the iterator might be part of.
+	 */
+	inner_iterator localEnd() const {
+		return seg_end;
+	}
+	/// move to the first voxel of the next chunk (or to the end of the image, if this is the last chunk)
+	ThisType &nextSegment() {
+		if ( ch_idx + 1 < ch_cnt ) {
+			setSegment( ch_idx + 1 );
+			current_it = seg_begin;
+		} else {
+			ch_idx = ch_cnt;
+			current_it = seg_end;
+		}
+
+		return *this;
 	}
 
 };
@@ -353,6 +422,15 @@ public:
 		return cnt;
 	}
 
+	/**
+	 * Split a list of chunks into groups, which can be made into images independently of each other.
+	 * Chunks which could be part of the same image always end up in the same group.
+	 * This is done in one pass using a hash of the size and the properties which have to be equal across an image.
+	 * \param chunks the chunks to be grouped (the list will be empty afterwards)
+	 * \returns the groups in the order of their first chunk in the given list
+	 */
+	static std::list<std::list<Chunk> > groupChunks( std::list<Chunk> &chunks );
+
 
 	/**
 	 * Create image from a single chunk.
@@ -501,6 +579,33 @@ public:
 		return ret; //return that
 	}
 
+	/**
+	 * Get a view of the chunk that contains the voxel at the given coordinates as the given type.
+	 * This is the lazy version of getChunkAs: no converted copy of the chunk is created, instead its voxels are converted on demand (see ValueArrayView).
+	 * The scaling is computed from the min/max of the whole image, so all views of an image are converted the same way.
+	 * \param first The first coordinate in voxel space. Usually the x value.
+	 * \param second The second coordinate in voxel space. Usually the y value.
+	 * \param third The third coordinate in voxel space. Ususally the z value.
+	 * \param fourth The fourth coordinate in voxel space. Usually the time value.
+	 * \returns a view of the voxels of the chunk containing the voxel at the given coordinates.
+	 */
+	template<typename TYPE> ValueArrayView<TYPE> getChunkViewAs ( size_t first, size_t second = 0, size_t third = 0, size_t fourth = 0 ) const {
+		return getChunkViewAs<TYPE> ( getScalingTo ( ValueArray<TYPE>::staticID ), first, second, third, fourth );
+	}
+	/**
+	 * Get a view of the chunk that contains the voxel at the given coordinates as the given type (fast version).
+	 * This version does not compute the scaling, and thus is much faster.
+	 * \param scaling the scaling (scale and offset) to be used when converting the voxels.
+	 * \param first The first coordinate in voxel space. Usually the x value.
+	 * \param second The second coordinate in voxel space. Usually the y value.
+	 * \param third The third coordinate in voxel space. Ususally the z value.
+	 * \param fourth The fourth coordinate in voxel space. Usually the time value.
+	 * \returns a view of the voxels of the chunk containing the voxel at the given coordinates.
+	 */
+	template<typename TYPE> ValueArrayView<TYPE> getChunkViewAs ( const scaling_pair &scaling, size_t first, size_t second = 0, size_t third = 0, size_t fourth = 0 ) const {
+		return getChunk ( first, second, third, fourth, false ).getViewAs<TYPE> ( scaling );
+	}
+
 	///for each chunk get the scaling (and offset) which would be used in an conversion to the given type
 	scaling_pair getScalingTo ( unsigned short typeID, autoscaleOption scaleopt = autoscale ) const;
 
@@ -565,6 +670,14 @@ public:
 	 */
 	size_t compare ( const Image &comp ) const;
 
+	/**
+	 * Compares the voxel-values of this image to the given using the given tolerance.
+	 * The chunks are compared in parallel (see ValueArrayBase::compare for the parameters).
+	 * If the images are of different size, all voxels are regarded different.
+	 * \returns the result of the comparison, CompareResult::first is the linear index of the first different voxel
+	 */
+	CompareResult compare ( const Image &comp, compareMode mode, double tolerance = 0, bool stopAtFirst = false ) const;
+
 	orientation getMainOrientation() const;
 
 	/**
@@ -781,6 +894,62 @@ public:
 	std::string identify( bool withpath = true )const;
 };
 
+/// @cond _internal
+namespace _internal
+{
+template<typename TYPE, typename OP> void forEachVoxelJob( Chunk ch, util::vector4<size_t> posInImage, OP op, size_t *errors )
+{
+	*errors = forEachVoxel<TYPE>( ch, op, posInImage );
+}
+}
+/// @endcond _internal
+
+/**
+ * Run a functor on every voxel of the image.
+ * Like Image::foreachVoxel all chunks are converted to TYPE first, but the functor is called directly (see forEachVoxel for chunks).
+ * \param img the image to work on
+ * \param op a functor which will be called as op(TYPE &vox, const util::vector4<size_t> &pos) with pos being the position in the image
+ * \param parallel if true, the chunks are processed in parallel by util::ThreadPool::global().
+ * In that case every chunk gets its own copy of op. So op must be copyable, and results stored in op itself will be lost.
+ * \returns amount of operations which returned false - so 0 is good! (all voxels count as failed if the conversion failed)
+ */
+template<typename TYPE, typename OP> size_t forEachVoxel( Image &img, OP &op, bool parallel = false )
+{
+	if( !img.checkMakeClean() || !img.convertToType( ValueArray<TYPE>::staticID ) )
+		return img.getVolume();
+
+	const util::vector4<size_t> imgSize = img.getSizeAsVector();
+	const util::vector4<size_t> chunkSize = img.getChunk( 0, 0, 0, 0, false ).getSizeAsVector();
+	std::vector<Chunk> chunks;
+	std::vector<util::vector4<size_t> > positions;
+	util::vector4<size_t> pos;
+
+	for( pos[timeDim] = 0; pos[timeDim] < imgSize[timeDim]; pos[timeDim] += chunkSize[timeDim] )
+		for( pos[sliceDim] = 0; pos[sliceDim] < imgSize[sliceDim]; pos[sliceDim] += chunkSize[sliceDim] )
+			for( pos[columnDim] = 0; pos[columnDim] < imgSize[columnDim]; pos[columnDim] += chunkSize[columnDim] )
+				for( pos[rowDim] = 0; pos[rowDim] < imgSize[rowDim]; pos[rowDim] += chunkSize[rowDim] ) {
+					chunks.push_back( img.getChunk( pos[rowDim], pos[columnDim], pos[sliceDim], pos[timeDim], false ) );
+					positions.push_back( pos );
+				}
+
+	std::vector<size_t> errors( chunks.size(), 0 );
+
+	if( parallel && chunks.size() > 1 ) {
+		std::vector<util::ThreadPool::job> jobs;
+		jobs.reserve( chunks.size() );
+
+		for( size_t i = 0; i < chunks.size(); i++ )
+			jobs.push_back( boost::bind( _internal::forEachVoxelJob<TYPE, OP>, chunks[i], positions[i], op, &errors[i] ) );
+
+		util::ThreadPool::global().run( jobs );
+	} else {
+		for( size_t i = 0; i < chunks.size(); i++ )
+			errors[i] = forEachVoxel<TYPE>( chunks[i], op, positions[i] );
+	}
+
+	return std::accumulate( errors.begin(), errors.end(), size_t( 0 ) );
+}
+
 /**
  * An Image where all chunks are guaranteed to have a specific type.
  * This not necessarily means, that all chunks in this image are a deep copy of their origin.
@@ -818,12 +987,7 @@ public:
 	}
 	iterator begin() {
 		if ( checkMakeClean() ) {
-			std::vector<data::ValueArray<T>*> vec ( lookup.size() );
-
-			for ( size_t i = 0; i < lookup.size(); i++ )
-				vec[i] = &lookup[i]->template asValueArray<T>();
-
-			return iterator ( vec );
+			return iterator ( lookup );
 		} else {
 			LOG ( Debug, error )  << "Image is not clean. Returning empty iterator ...";
 			return iterator();
@@ -834,12 +998,7 @@ public:
 	};
 	const_iterator begin() const {
 		if ( isClean() ) {
-			std::vector<const data::ValueArray<T>*> vec ( lookup.size() );
-
-			for ( size_t i = 0; i < lookup.size(); i++ )
-				vec[i] = &lookup[i]->template asValueArray<T>();
-
-			return const_iterator ( vec );
+			return const_iterator ( lookup );
 		} else {
 			LOG ( Debug, error )  << "Image is not clean. Returning empty iterator ...";
 			return const_iterator();
@@ -23,6 +23,7 @@
 
 #include "io_application.hpp"
 #include "io_factory.hpp"
+#include "fileptr.hpp"
 #include <boost/mpl/for_each.hpp>
 
 
@@ -30,6 +31,25 @@ namespace isis
 {
 namespace data
 {
+namespace
+{
+/// sets the default read mode of FilePtr, and restores the old one when it goes out of scope (also if loading throws)
+class DefaultReadModeSetter
+{
+	const FilePtr::readMode m_old;
+	const bool m_set;
+public:
+	DefaultReadModeSetter( FilePtr::readMode mode ): m_old( FilePtr::getDefaultReadMode() ), m_set( mode != FilePtr::read_default ) {
+		if( m_set )
+			FilePtr::setDefaultReadMode( mode );
+	}
+	~DefaultReadModeSetter() {
+		if( m_set )
+			FilePtr::setDefaultReadMode( m_old );
+	}
+};
+}
+
 IOApplication::IOApplication( const char name[], bool have_input, bool have_output ):
 	Application( name ),
 	m_input( have_input ), m_output( have_output ), feedback( new util::ConsoleFeedback )
@@ -80,6 +100,13 @@ void IOApplication::addInput ( util::ParameterMap &parameters, bool needed, cons
 	parameters[std::string( "rdialect" ) + suffix].setDescription(
 		std::string( "choose dialect for reading" ) + desc + ". The available dialects depend on the capabilities of the used IO plugin" );
 
+	parameters[std::string( "rmode" ) + suffix] = util::Selection( "default,mmap,pread,direct", "default" );
+	parameters[std::string( "rmode" ) + suffix].needed() = false;
+	parameters[std::string( "rmode" ) + suffix].hidden() = true;
+	parameters[std::string( "rmode" ) + suffix].setDescription(
+		std::string( "how to read the files" ) + desc + " (if the IO plugin supports it): \"mmap\" maps them into memory, \"pread\" reads them at once in big blocks, "
+		"\"direct\" does the same bypassing the page cache. \"default\" is taken from the environment variable ISIS_FILE_READ, or \"mmap\" if that is not set" );
+
 	if( parameters.find( "np" ) == parameters.end() ) {
 		parameters["np"] = false;
 		parameters["np"].needed() = false;
@@ -180,7 +207,13 @@ bool IOApplication::autoload ( const util::ParameterMap &parameters, std::list<I
 		data::IOFactory::setProgressFeedback( feedback );
 	}
 
-	const std::list< Image > tImages = data::IOFactory::load( input, rf.c_str(), dl.c_str() );
+	const util::Selection rmode = parameters[std::string( "rmode" ) + suffix];
+	std::list< Image > tImages;
+	{
+		// the plugins open the files themselves, so the mode can only be given to them as default
+		const DefaultReadModeSetter mode_setter( rmode > 1 ? static_cast<FilePtr::readMode>( rmode - 1 ) : FilePtr::read_default ); //default is 0 but 1 in the selection
+		tImages = data::IOFactory::load( input, rf.c_str(), dl.c_str() );
+	}
 
 	images.insert( images.end(), tImages.begin(), tImages.end() );
 
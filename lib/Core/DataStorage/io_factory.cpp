@@ -30,6 +30,8 @@
 #include <boost/system/error_code.hpp>
 #include <boost/algorithm/string.hpp>
 #include "../CoreUtils/singletons.hpp"
+#include "../CoreUtils/threadpool.hpp"
+#include "prefetcher.hpp"
 
 namespace isis
 {
@@ -78,7 +80,7 @@ bool invalid_and_tell( Chunk &candidate )
 /// @endcond _internal
 API_EXCLUDE_BEGIN
 
-IOFactory::IOFactory()
+IOFactory::IOFactory(): m_load_concurrency( 0 )
 {
 	const char *env_path = getenv( "ISIS_PLUGIN_PATH" );
 	const char *env_home = getenv( "HOME" );
@@ -215,6 +217,11 @@ IOFactory &IOFactory::get()
 }
 
 size_t IOFactory::loadFile( std::list<Chunk> &ret, const boost::filesystem::path &filename, util::istring suffix_override, util::istring dialect )
+{
+	return loadFile( ret, filename, suffix_override, dialect, m_feedback );
+}
+
+size_t IOFactory::loadFile( std::list<Chunk> &ret, const boost::filesystem::path &filename, util::istring suffix_override, util::istring dialect, boost::shared_ptr<util::ProgressFeedback> feedback )
 {
 	FileFormatList formatReader;
 	formatReader = getFileFormatList( filename.string(), suffix_override, dialect );
@@ -237,10 +244,11 @@ size_t IOFactory::loadFile( std::list<Chunk> &ret, const boost::filesystem::path
 					<< "plugin to load file" << with_dialect << " " << util::MSubject( filename ) << ": " << it->getName();
 
 			try {
-				int loaded=it->load( ret, filename.native(), dialect, m_feedback );
+				int loaded=it->load( ret, filename.native(), dialect, feedback );
+				static const util::PropertyMap::PropPath sourceProp( "source" );
 				BOOST_FOREACH( Chunk & ref, ret ) {
-					if ( ! ref.hasProperty( "source" ) )
-						ref.setPropertyAs( "source", filename.native() );
+					if ( ! ref.hasProperty( sourceProp ) )
+						ref.setPropertyAs( sourceProp, filename.native() );
 				}
 				return loaded;
 			} catch ( std::runtime_error &e ) {
@@ -307,23 +315,28 @@ std::list< Image > IOFactory::chunkListToImageList( std::list<Chunk> &src )
 
 	std::list< Image > ret;
 
-	while ( !src.empty() ) {
-		LOG( Debug, info ) << src.size() << " Chunks left to be distributed.";
-		size_t before = src.size();
+	// chunks which cannot be part of the same image are separated first, so each image is only made from the chunks which could fit
+	std::list<std::list<Chunk> > groups = Image::groupChunks( src );
 
-		Image buff( src );
+	BOOST_FOREACH( std::list<Chunk> &group, groups ) {
+		while ( !group.empty() ) {
+			LOG( Debug, info ) << group.size() << " Chunks left to be distributed.";
+			size_t before = group.size();
 
-		if ( buff.isClean() ) {
-			if( buff.isValid() ) { //if the image was successfully indexed and is valid, keep it
-				ret.push_back( buff );
-				LOG( Runtime, info ) << "Image " << ret.size() << " with size " << util::MSubject( buff.getSizeAsString() ) << " done.";
-			} else {
-				LOG_IF( !buff.getMissing().empty(), Runtime, error )
-						<< "Cannot insert image. Missing properties: " << buff.getMissing();
-				errcnt += before - src.size();
-			}
-		} else
-			LOG( Runtime, info ) << "Dropping non clean Image";
+			Image buff( group );
+
+			if ( buff.isClean() ) {
+				if( buff.isValid() ) { //if the image was successfully indexed and is valid, keep it
+					ret.push_back( buff );
+					LOG( Runtime, info ) << "Image " << ret.size() << " with size " << util::MSubject( buff.getSizeAsString() ) << " done.";
+				} else {
+					LOG_IF( !buff.getMissing().empty(), Runtime, error )
+							<< "Cannot insert image. Missing properties: " << buff.getMissing();
+					errcnt += before - group.size();
+				}
+			} else
+				LOG( Runtime, info ) << "Dropping non clean Image";
+		}
 	}
 
 	LOG_IF( errcnt, Runtime, warning ) << "Dropped " << errcnt << " chunks because they didn't form valid images";
@@ -339,11 +352,42 @@ size_t IOFactory::load( std::list<data::Chunk> &chunks, const std::string &path,
 	return loaded;
 }
 
+size_t IOFactory::load( std::list<data::Chunk> &chunks, const data::ValueArray<uint8_t> &data, const std::string &filename, util::istring suffix_override, util::istring dialect )
+{
+	const FileFormatList formatReader = getFileFormatList( filename, suffix_override, dialect );
+	LOG_IF( formatReader.empty(), Runtime, error ) << "No plugin found to read " << util::MSubject( filename ) << " from memory";
+
+	BOOST_FOREACH( FileFormatList::const_reference it, formatReader ) {
+		LOG( Debug, info ) << "plugin to load " << util::MSubject( filename ) << " from memory: " << it->getName();
+		std::list<Chunk> loaded;
+
+		try {
+			const int ret = it->load( loaded, data, filename, dialect, get().m_feedback );
+			BOOST_FOREACH( Chunk & ref, loaded ) {
+				if ( ! ref.hasProperty( "source" ) )
+					ref.setPropertyAs( "source", filename );
+			}
+			chunks.splice( chunks.end(), loaded );
+			return ret;
+		} catch ( std::runtime_error &e ) {
+			LOG( Runtime, formatReader.size() > 1 ? warning : error )
+					<< "Failed to load " <<  util::MSubject( filename ) << " from memory using " <<  it->getName() << " ( " << e.what() << " )";
+		}
+	}
+
+	return 0;
+}
+
 std::list< Image > IOFactory::load ( const util::slist &paths, util::istring suffix_override, util::istring dialect )
 {
 	std::list<Chunk> chunks;
 	size_t loaded = 0;
+	// read the files ahead while the ones before them are loaded (directories do that themselves)
+	const std::vector<boost::filesystem::path> files( paths.begin(), paths.end() );
+	FilePrefetcher prefetcher( files );
+	size_t i = 0;
 	BOOST_FOREACH( const std::string & path, paths ) {
+		prefetcher.advance( i++ );
 		loaded += load( chunks, path , suffix_override, dialect );
 	}
 	const std::list<data::Image> images = chunkListToImageList( chunks );
@@ -357,28 +401,67 @@ std::list<data::Image> IOFactory::load( const std::string &path, util::istring s
 	return load( util::slist( 1, path ), suffix_override, dialect );
 }
 
+void IOFactory::loadFileJob( const boost::filesystem::path &filename, std::list<Chunk> &ret, size_t &loaded, util::istring suffix_override, util::istring dialect, boost::shared_ptr<util::ProgressFeedback> feedback, FilePrefetcher *prefetcher, size_t idx )
+{
+	prefetcher->advance( idx );
+	loaded = loadFile( ret, filename, suffix_override, dialect, feedback );
+
+	if( feedback )
+		feedback->progress();
+}
+
 size_t IOFactory::loadPath( std::list<Chunk> &ret, const boost::filesystem::path &path, util::istring suffix_override, util::istring dialect )
 {
-	int loaded = 0;
+	std::vector<boost::filesystem::path> files;
+
+	for ( boost::filesystem::directory_iterator i( path ); i != boost::filesystem::directory_iterator(); ++i )  {
+		if ( !boost::filesystem::is_directory( *i ) )
+			files.push_back( *i );
+	}
+
+	// the plugins might report progress from different threads, so they get a locked version of the feedback
+	boost::shared_ptr<util::ProgressFeedback> feedback;
 
 	if( m_feedback ) {
-		const size_t length = std::distance( boost::filesystem::directory_iterator( path ), boost::filesystem::directory_iterator() ); //@todo this will also count directories
-		m_feedback->show( length, std::string( "Reading " ) + util::Value<std::string>( length ).toString( false ) + " files from " + path.native() );
+		m_feedback->show( files.size(), std::string( "Reading " ) + util::Value<std::string>( files.size() ).toString( false ) + " files from " + path.native() );
+		feedback.reset( new util::LockedFeedback( m_feedback ) );
 	}
 
-	for ( boost::filesystem::directory_iterator i( path ); i != boost::filesystem::directory_iterator(); ++i )  {
-		if ( boost::filesystem::is_directory( *i ) )continue;
+	// each file is loaded into its own list, so the result does not depend on which file was done first
+	std::vector<std::list<Chunk> > chunks( files.size() );
+	std::vector<size_t> loaded( files.size(), 0 );
+	std::vector<util::ThreadPool::job> jobs;
+	jobs.reserve( files.size() );
+	// the jobs are started in the order of the files, so the next files can be read while the current ones are parsed
+	FilePrefetcher prefetcher( files );
+
+	for( size_t i = 0; i < files.size(); i++ ) {
+		jobs.push_back( boost::bind(
+							&IOFactory::loadFileJob, this, boost::cref( files[i] ), boost::ref( chunks[i] ), boost::ref( loaded[i] ), suffix_override, dialect, feedback, &prefetcher, i
+						) );
+	}
 
-		loaded += loadFile( ret, *i, suffix_override, dialect );
+	if( m_load_pool ) {
+		m_load_pool->run( jobs );
+	} else if( m_load_concurrency == 0 ) {
+		util::ThreadPool::global().run( jobs );
+	} else {
+		BOOST_FOREACH( const util::ThreadPool::job & job, jobs ) {
+			job();
+		}
+	}
 
-		if( m_feedback )
-			m_feedback->progress();
+	size_t ret_loaded = 0;
+
+	for( size_t i = 0; i < files.size(); i++ ) {
+		ret.splice( ret.end(), chunks[i] );
+		ret_loaded += loaded[i];
 	}
 
 	if( m_feedback )
 		m_feedback->close();
 
-	return loaded;
+	return ret_loaded;
 }
 
 bool IOFactory::write( const data::Image &image, const std::string &path, util::istring suffix_override, util::istring dialect )
@@ -435,6 +518,13 @@ void IOFactory::setProgressFeedback( boost::shared_ptr<util::ProgressFeedback> f
 	This.m_feedback = feedback;
 }
 
+void IOFactory::setLoadConcurrency( size_t concurrency )
+{
+	IOFactory &This = get();
+	This.m_load_concurrency = concurrency;
+	This.m_load_pool.reset( concurrency > 1 ? new util::ThreadPool( concurrency ) : NULL );
+}
+
 IOFactory::FileFormatList IOFactory::getFormats()
 {
 	return get().io_formats;
@@ -31,8 +31,13 @@
 
 namespace isis
 {
+namespace util
+{
+class ThreadPool;
+}
 namespace data
 {
+class FilePrefetcher;
 
 class IOFactory
 {
@@ -43,6 +48,8 @@ public:
 
 private:
 	boost::shared_ptr<util::ProgressFeedback> m_feedback;
+	size_t m_load_concurrency;
+	boost::shared_ptr<util::ThreadPool> m_load_pool;
 	// use ImageIO's logging here instead of the normal data::Runtime/Debug
 	typedef ImageIoLog Runtime;
 	typedef ImageIoDebug Debug;
@@ -73,6 +80,17 @@ public:
 	 * @return list of chunks (part of an image)
 	 */
 	static size_t load( std::list<data::Chunk> &chunks, const std::string &path, util::istring suffix_override = "", util::istring dialect = "" );
+	/**
+	 * Load data which already are in memory (e.g. a decompressed file) and store them in the given chunk list.
+	 * Plugins which cannot read from memory get the data as temporary file (see image_io::FileFormat::load).
+	 * @param chunks list to store the loaded chunks in
+	 * @param data the content of the file
+	 * @param filename the name of the file the data are from (it selects the plugin, and is the source of the loaded chunks)
+	 * @param suffix_override override the given suffix with this one (especially if there's no suffix)
+	 * @param dialect dialect of the fileformat to load
+	 * @return number of chunks loaded
+	 */
+	static size_t load( std::list<data::Chunk> &chunks, const data::ValueArray<uint8_t> &data, const std::string &filename, util::istring suffix_override = "", util::istring dialect = "" );
 
 	static bool write( const data::Image &image, const std::string &path, util::istring suffix_override = "", util::istring dialect = "" );
 	static bool write( std::list<data::Image> images, const std::string &path, util::istring suffix_override = "", util::istring dialect = "" );
@@ -82,6 +100,15 @@ public:
 
 	static void setProgressFeedback( boost::shared_ptr<util::ProgressFeedback> feedback );
 
+	/**
+	 * Set how many files of a directory are loaded in parallel.
+	 * The results are merged in the order of the files, so the loaded chunks don't depend on this.
+	 * \param concurrency maximum number of files loaded at once (0 means as many as util::ThreadPool::global() can run, which is the default)
+	 *
+	 * While files are loaded, the files behind them are read ahead (see FilePrefetcher::setDefaultDepth).
+	 */
+	static void setLoadConcurrency( size_t concurrency );
+
 	/**
 	 * Get all formats which should be able to read/write the given file.
 	 * \param filename the file which should be red/written
@@ -99,7 +126,9 @@ public:
 	static std::list<data::Image> chunkListToImageList( std::list<Chunk> &chunks );
 protected:
 	size_t loadFile( std::list<Chunk> &ret, const boost::filesystem::path &filename, util::istring suffix_override = "", util::istring dialect = "" );
+	size_t loadFile( std::list<Chunk> &ret, const boost::filesystem::path &filename, util::istring suffix_override, util::istring dialect, boost::shared_ptr<util::ProgressFeedback> feedback );
 	size_t loadPath( std::list<Chunk> &ret, const boost::filesystem::path &path, util::istring suffix_override = "", util::istring dialect = "" );
+	void loadFileJob( const boost::filesystem::path &filename, std::list<Chunk> &ret, size_t &loaded, util::istring suffix_override, util::istring dialect, boost::shared_ptr<util::ProgressFeedback> feedback, FilePrefetcher *prefetcher, size_t idx );
 
 	static IOFactory &get();
 	IOFactory();//shall not be created directly
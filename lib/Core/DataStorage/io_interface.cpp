@@ -11,6 +11,9 @@
 #include "../CoreUtils/log.hpp"
 #include "common.hpp"
 #include "io_interface.h"
+#include "fileptr.hpp"
+#include "../CoreUtils/tmpfile.hpp"
+#include <string.h>
 
 namespace isis
 {
@@ -25,6 +28,24 @@ bool moreCmp( const util::istring &a, const util::istring &b ) {return a.length(
 /// @endcond _internal
 API_EXCLUDE_END
 
+int FileFormat::load( std::list<data::Chunk> &chunks, const data::ValueArray<uint8_t> &data, const std::string &filename, const util::istring &dialect, boost::shared_ptr<util::ProgressFeedback> feedback ) throw( std::runtime_error & )
+{
+	if( data.getLength() == 0 )
+		throwGenericError( filename + " is empty" );
+
+	util::TmpFile tmpfile( "", makeBasename( filename ).second ); // keep the suffix, some plugins need it
+	data::FilePtr mfile( tmpfile, data.getLength(), true );
+
+	if( !mfile.good() )
+		throwSystemError( errno, std::string( "Failed to open temporary " ) + tmpfile.native() );
+
+	LOG( Debug, info ) << getName() << " cannot read from memory, writing " << data.getLength() << " bytes of " << util::MSubject( filename ) << " to " << tmpfile.native();
+	memcpy( &mfile[0], &data[0], data.getLength() );
+	mfile.release(); //close and unmap the temporary file
+
+	return load( chunks, tmpfile.native(), dialect, feedback );
+}
+
 void FileFormat::write( const std::list< data::Image >& images, const std::string &filename, const util::istring &dialect, boost::shared_ptr< util::ProgressFeedback > progress ) throw( std::runtime_error & )
 {
 	std::list<std::string> names = makeUniqueFilenames( images, filename );
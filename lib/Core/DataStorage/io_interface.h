@@ -107,6 +107,20 @@ public:
 	virtual int load( std::list<data::Chunk> &chunks, const std::string &filename, const util::istring &dialect, boost::shared_ptr<util::ProgressFeedback> feedback )
 	throw( std::runtime_error & ) = 0; //@todo should be locked
 
+	/**
+	 * Load data which already are in memory (e.g. a decompressed file) into the given chunk list.
+	 * I case of an error std::runtime_error will be thrown.
+	 * The default implementation writes the data into a temporary file and loads that, plugins which can read from memory should override it.
+	 * \param chunks the chunk list where the loaded chunks shall be added to
+	 * \param data the content of the file
+	 * \param filename the name of the file the data are from (it does not have to exist, but its suffix is used)
+	 * \param dialect the dialect to be used when loading the file (use "" to not define a dialect)
+	 * \param feedback a shared_ptr to a ProgressFeedback-object to inform about loading progress. Not used if zero.
+	 * \returns the amount of loaded chunks.
+	 */
+	virtual int load( std::list<data::Chunk> &chunks, const data::ValueArray<uint8_t> &data, const std::string &filename, const util::istring &dialect, boost::shared_ptr<util::ProgressFeedback> feedback )
+	throw( std::runtime_error & );
+
 	/**
 	 * Write a single image to a file.
 	 * I case of an error std::runtime_error will be thrown.
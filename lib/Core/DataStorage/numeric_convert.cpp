@@ -18,12 +18,9 @@
 */
 
 #include "numeric_convert.hpp"
-
-#ifdef ISIS_USE_LIBOIL
-extern "C" {
-#include <liboil/liboil.h>
-}
-
+#include <stdlib.h>
+#include <boost/algorithm/string/predicate.hpp>
+#include <cmath>
 
 namespace isis
 {
@@ -33,142 +30,233 @@ API_EXCLUDE_BEGIN
 namespace _internal
 {
 
-/** some liboil based explicit implementations of numeric_convert_impl(const Src* src, Dst* dst, unsigned int count) */
+namespace
+{
+simdLevel detectSimdLevel()
+{
+	simdLevel ret = simd_none;
+#if ISIS_SIMD_DISPATCH
+	__builtin_cpu_init();
+
+	if( __builtin_cpu_supports( "sse2" ) ) {
+		ret = simd_sse2;
+
+		if( __builtin_cpu_supports( "avx2" ) ) {
+			ret = simd_avx2;
+
+			if( __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" ) &&
+				__builtin_cpu_supports( "avx512dq" ) && __builtin_cpu_supports( "avx512vl" )
+			  )
+				ret = simd_avx512;
+		}
+	}
+
+#endif
+	const char *env_cap = getenv( "ISIS_SIMD" );
+
+	if( env_cap ) {
+		for( int cap = simd_none; cap <= simd_avx512; cap++ ) {
+			if( boost::iequals( env_cap, getSimdName( static_cast<simdLevel>( cap ) ) ) ) {
+				LOG_IF( cap > ret, Runtime, warning )
+						<< "Ignoring request for " << util::MSubject( env_cap ) << " from ISIS_SIMD, this cpu only supports " << getSimdName( ret );
+				ret = std::min( ret, static_cast<simdLevel>( cap ) );
+				break;
+			}
+		}
+	}
+
+	LOG( Runtime, info ) << "Using " << util::MSubject( getSimdName( ret ) ) << " for numeric kernels";
+	return ret;
+}
+
+// the tolerance of a comparison as used by the compare kernels
+struct CompareTolerance {
+	bool exact;
+	double absolute, relative;
+};
+template<typename T> bool isDifferent( T a, T b, const CompareTolerance &tol )
+{
+	const double diff = std::fabs( static_cast<double>( a ) - static_cast<double>( b ) );
+	const double limit = tol.absolute + tol.relative * std::max( std::fabs( static_cast<double>( a ) ), std::fabs( static_cast<double>( b ) ) );
+	const bool nans = a != a && b != b; // NaN is equal to NaN (always false for integers)
+	return a != b && !nans && ( tol.exact || !( diff <= limit ) ); // NaN compared to a number is different
+}
+// compare a pair of values and add the result to the counters of one lane of a compare kernel
+template<typename T> void compareValues( T a, T b, const CompareTolerance &tol, size_t &different, double &maxDiff, double &squares )
+{
+	const double diff = static_cast<double>( a ) - static_cast<double>( b ), absDiff = std::fabs( diff );
+	different += isDifferent( a, b, tol );
+	maxDiff = absDiff > maxDiff ? absDiff : maxDiff;
+	squares += absDiff == absDiff ? diff * diff : 0; // leave out pairs with NaN
+}
+
+/*
+ * The conversion kernels are plain loops, which are compiled once for each supported instruction set.
+ * The compiler vectorizes them (see the COMPILE_FLAGS of this file in CMakeLists.txt).
+ * round and saturate are branch free selects after inlining so the vectorizer can deal with them.
+ * The compare kernel keeps independent counters for a few lanes, so the reductions don't depend on each other
+ * and can be vectorized without reordering floating point additions.
+ */
+static const size_t compare_lanes = 8;
+#define DEF_KERNELS(NAME,ATTRIBUTE)                                                                                                 \
+	template<typename SRC, typename DST> ATTRIBUTE void NAME ## _convert( const SRC *src, DST *dst, size_t count ){                 \
+		for ( size_t i = 0; i < count; i++ )                                                                                        \
+			dst[i] = saturate<SRC, DST>( src[i] );                                                                                  \
+	}                                                                                                                               \
+	template<typename SRC, typename DST> ATTRIBUTE void NAME ## _scaled_convert( const SRC *src, DST *dst, size_t count, double scale, double offset ){ \
+		for ( size_t i = 0; i < count; i++ )                                                                                        \
+			dst[i] = round<DST>( src[i] * scale + offset );                                                                         \
+	}                                                                                                                               \
+	template<typename T> ATTRIBUTE void NAME ## _compare( const T *a, const T *b, size_t count, const CompareTolerance &tol, CompareResult &result ){ \
+		size_t different[compare_lanes] = {0}, i = 0;                                                                               \
+		double maxDiff[compare_lanes] = {0}, squares[compare_lanes] = {0};                                                          \
+		for ( ; i + compare_lanes <= count; i += compare_lanes )                                                                    \
+			for ( size_t l = 0; l < compare_lanes; l++ )                                                                            \
+				compareValues( a[i + l], b[i + l], tol, different[l], maxDiff[l], squares[l] );                                     \
+		for ( ; i < count; i++ )                                                                                                    \
+			compareValues( a[i], b[i], tol, different[0], maxDiff[0], squares[0] );                                                 \
+		for ( size_t l = 0; l < compare_lanes; l++ ) {                                                                              \
+			result.different += different[l];                                                                                       \
+			result.maxAbsDiff = std::max( result.maxAbsDiff, maxDiff[l] );                                                          \
+			result.sumSquares += squares[l];                                                                                        \
+		}                                                                                                                           \
+		result.compared += count;                                                                                                   \
+	}
+
+DEF_KERNELS( generic, ISIS_TARGET_DEFAULT )
+#if ISIS_SIMD_DISPATCH
+DEF_KERNELS( avx2, ISIS_TARGET_AVX2 )
+DEF_KERNELS( avx512, ISIS_TARGET_AVX512 )
+#endif
+#undef DEF_KERNELS
+
+template<typename SRC, typename DST> struct Kernels {
+	typedef void ( *convert_fn )( const SRC *, DST *, size_t );
+	typedef void ( *scaled_convert_fn )( const SRC *, DST *, size_t, double, double );
+	static convert_fn getConvert() {
+		switch( getSimdLevel() ) {
+#if ISIS_SIMD_DISPATCH
+		case simd_avx512:
+			return avx512_convert<SRC, DST>;
+		case simd_avx2:
+			return avx2_convert<SRC, DST>;
+#endif
+		default: // sse2 is part of the baseline of x86_64, so the generic kernel is vectorized with it
+			return generic_convert<SRC, DST>;
+		}
+	}
+	static scaled_convert_fn getScaledConvert() {
+		switch( getSimdLevel() ) {
+#if ISIS_SIMD_DISPATCH
+		case simd_avx512:
+			return avx512_scaled_convert<SRC, DST>;
+		case simd_avx2:
+			return avx2_scaled_convert<SRC, DST>;
+#endif
+		default:
+			return generic_scaled_convert<SRC, DST>;
+		}
+	}
+};
+
+template<typename T> struct CompareKernel {
+	typedef void ( *compare_fn )( const T *, const T *, size_t, const CompareTolerance &, CompareResult & );
+	static compare_fn get() {
+		switch( getSimdLevel() ) {
+#if ISIS_SIMD_DISPATCH
+		case simd_avx512:
+			return avx512_compare<T>;
+		case simd_avx2:
+			return avx2_compare<T>;
+#endif
+		default:
+			return generic_compare<T>;
+		}
+	}
+};
+}
+
+template<typename T> CompareResult numeric_compare_impl( const T *a, const T *b, size_t count, compareMode mode, double tolerance, bool stopAtFirst )
+{
+	static const size_t step = 4096; // small enough to stop early, big enough to not slow down the kernel
+	static const typename CompareKernel<T>::compare_fn kernel = CompareKernel<T>::get();
+	const CompareTolerance tol = {mode == compare_exact, mode == compare_absolute ? tolerance : 0, mode == compare_relative ? tolerance : 0};
+	CompareResult ret;
+
+	for( size_t start = 0; start < count && !( stopAtFirst && ret.different ); start += step ) {
+		CompareResult part;
+		kernel( a + start, b + start, std::min( step, count - start ), tol, part );
 
-#define IMPL_CONVERT(SRC,DST,SRC_KEY,DST_KEY)                                               \
-	template<> void numeric_convert_impl<SRC,DST>( const SRC *src, DST *dst, size_t count ){\
-		LOG( Runtime, info )                                                                \
-				<< "using optimized convert " << ValueArray<SRC>::staticName() << " => "      \
-				<< ValueArray<DST>::staticName() << " without scaling";                       \
-		oil_conv_ ## DST_KEY ## _ ## SRC_KEY (dst,sizeof(DST),src,sizeof(SRC),count);       \
+		if( part.different ) // find the first difference in this part
+			for( part.first = 0; !isDifferent( a[start + part.first], b[start + part.first], tol ); part.first++ );
+
+		ret += part;
 	}
 
-#define IMPL_SCALED_CONVERT(SRC,DST,SRC_KEY,DST_KEY)                                                                       \
-	template<> void numeric_convert_impl<SRC,DST>( const SRC *src, DST *dst, size_t count, double scale, double offset ){  \
-		LOG( Runtime, info )                                                                                               \
-				<< "using optimized scaling convert " << ValueArray<SRC>::staticName() << "=>" << ValueArray<DST>::staticName()\
-				<< " with scale/offset " << std::fixed << scale << "/" << offset;                                          \
-		oil_scaleconv_ ## DST_KEY ## _ ## SRC_KEY (dst,src,count,&offset,&scale);                                          \
+	return ret;
+}
+
+/** explicit implementations of numeric_convert_impl for all numeric types, dispatched at runtime */
+
+#define IMPL_CONVERT(SRC,DST)                                                                                                       \
+	template<> void numeric_convert_impl<SRC,DST>( const SRC *src, DST *dst, size_t count ){                                        \
+		static const Kernels<SRC, DST>::convert_fn kernel = Kernels<SRC, DST>::getConvert();                                        \
+		LOG( Runtime, info )                                                                                                        \
+				<< "using " << getSimdName( getSimdLevel() ) << " convert " << ValueArray<SRC>::staticName() << " => "              \
+				<< ValueArray<DST>::staticName() << " without scaling";                                                             \
+		kernel( src, dst, count );                                                                                                  \
+	}                                                                                                                               \
+	template<> void numeric_convert_impl<SRC,DST>( const SRC *src, DST *dst, size_t count, double scale, double offset ){           \
+		static const Kernels<SRC, DST>::scaled_convert_fn kernel = Kernels<SRC, DST>::getScaledConvert();                           \
+		LOG( Runtime, info )                                                                                                        \
+				<< "using " << getSimdName( getSimdLevel() ) << " scaling convert " << ValueArray<SRC>::staticName() << "=>"        \
+				<< ValueArray<DST>::staticName() << " with scale/offset " << std::fixed << scale << "/" << offset;                  \
+		kernel( src, dst, count, scale, offset );                                                                                   \
 	}
 
-//>>s32
-IMPL_CONVERT( float, int32_t, f32, s32 )
-IMPL_CONVERT( double, int32_t, f64, s32 )
-IMPL_CONVERT( uint32_t, int32_t, u32, s32 )
-IMPL_CONVERT( int16_t, int32_t, s16, s32 )
-IMPL_CONVERT( uint16_t, int32_t, u16, s32 )
-IMPL_CONVERT( int8_t, int32_t, s8, s32 )
-IMPL_CONVERT( uint8_t, int32_t, u8, s32 )
-
-//>>u32
-//IMPL_CONVERT(float,uint32_t,f32,u32)
-//IMPL_CONVERT(double,uint32_t,f64,u32)
-IMPL_CONVERT( int32_t, uint32_t, s32, u32 )
-//IMPL_CONVERT(int16_t,uint32_t,s16,u32) ** Not available in liboil - but should be imho
-IMPL_CONVERT( uint16_t, uint32_t, u16, u32 )
-//IMPL_CONVERT(int8_t,uint32_t,s8,u32) ** Not available in liboil - but should be imho
-IMPL_CONVERT( uint8_t, uint32_t, u8, u32 )
-
-//>>s16
-IMPL_CONVERT( float, int16_t, f32, s16 )
-IMPL_CONVERT( double, int16_t, f64, s16 )
-IMPL_CONVERT( int32_t, int16_t, s32, s16 )
-IMPL_CONVERT( uint32_t, int16_t, u32, s16 )
-IMPL_CONVERT( uint16_t, int16_t, u16, s16 )
-IMPL_CONVERT( int8_t, int16_t, s8, s16 )
-IMPL_CONVERT( uint8_t, int16_t, u8, s16 )
-
-//>>u16
-IMPL_CONVERT( float, uint16_t, f32, u16 )
-IMPL_CONVERT( double, uint16_t, f64, u16 )
-IMPL_CONVERT( int32_t, uint16_t, s32, u16 )
-IMPL_CONVERT( uint32_t, uint16_t, u32, u16 )
-IMPL_CONVERT( int16_t, uint16_t, s16, u16 )
-//IMPL_CONVERT(int8_t,uint16_t,s8,u16) ** Not available in liboil - but should be imho
-IMPL_CONVERT( uint8_t, uint16_t, u8, u16 )
-
-//>>s8
-IMPL_CONVERT( float, int8_t, f32, s8 )
-IMPL_CONVERT( double, int8_t, f64, s8 )
-IMPL_CONVERT( int32_t, int8_t, s32, s8 )
-IMPL_CONVERT( uint32_t, int8_t, u32, s8 )
-IMPL_CONVERT( int16_t, int8_t, s16, s8 )
-IMPL_CONVERT( uint16_t, int8_t, u16, s8 )
-IMPL_CONVERT( uint8_t, int8_t, u8, s8 )
-
-//>>u8
-IMPL_CONVERT( float, uint8_t, f32, u8 )
-IMPL_CONVERT( double, uint8_t, f64, u8 )
-IMPL_CONVERT( int32_t, uint8_t, s32, u8 )
-IMPL_CONVERT( uint32_t, uint8_t, u32, u8 )
-IMPL_CONVERT( int16_t, uint8_t, s16, u8 )
-IMPL_CONVERT( uint16_t, uint8_t, u16, u8 )
-IMPL_CONVERT( int8_t, uint8_t, s8, u8 )
-
-//>>f32
-IMPL_CONVERT( double, float, f64, f32 )
-IMPL_CONVERT( int32_t, float, s32, f32 )
-IMPL_CONVERT( uint32_t, float, u32, f32 )
-IMPL_CONVERT( int16_t, float, s16, f32 )
-IMPL_CONVERT( uint16_t, float, u16, f32 )
-IMPL_CONVERT( int8_t, float, s8, f32 )
-IMPL_CONVERT( uint8_t, float, u8, f32 )
-
-//>>f64
-IMPL_CONVERT( float, double, f32, f64 )
-IMPL_CONVERT( int32_t, double, s32, f64 )
-IMPL_CONVERT( uint32_t, double, u32, f64 )
-IMPL_CONVERT( int16_t, double, s16, f64 )
-IMPL_CONVERT( uint16_t, double, u16, f64 )
-IMPL_CONVERT( int8_t, double, s8, f64 )
-IMPL_CONVERT( uint8_t, double, u8, f64 )
-
-
-//scale>>s32
-IMPL_SCALED_CONVERT( float, int32_t, f32, s32 )
-IMPL_SCALED_CONVERT( double, int32_t, f64, s32 )
-
-//scale>>u32
-//IMPL_SCALED_CONVERT(float,uint32_t,f32,u32)
-//IMPL_SCALED_CONVERT(double,uint32_t,f64,u32)
-
-//scale>>s16
-IMPL_SCALED_CONVERT( float, int16_t, f32, s16 )
-IMPL_SCALED_CONVERT( double, int16_t, f64, s16 )
-
-//scale>>u16
-IMPL_SCALED_CONVERT( float, uint16_t, f32, u16 )
-IMPL_SCALED_CONVERT( double, uint16_t, f64, u16 )
-
-//scale>>s8
-IMPL_SCALED_CONVERT( float, int8_t, f32, s8 )
-IMPL_SCALED_CONVERT( double, int8_t, f64, s8 )
-
-//scale>>u8
-IMPL_SCALED_CONVERT( float, uint8_t, f32, u8 )
-IMPL_SCALED_CONVERT( double, uint8_t, f64, u8 )
-
-//scale>>f32
-IMPL_SCALED_CONVERT( int32_t, float, s32, f32 )
-IMPL_SCALED_CONVERT( uint32_t, float, u32, f32 )
-IMPL_SCALED_CONVERT( int16_t, float, s16, f32 )
-IMPL_SCALED_CONVERT( uint16_t, float, u16, f32 )
-IMPL_SCALED_CONVERT( int8_t, float, s8, f32 )
-IMPL_SCALED_CONVERT( uint8_t, float, u8, f32 )
-
-//scale>>f64
-IMPL_SCALED_CONVERT( int32_t, double, s32, f64 )
-IMPL_SCALED_CONVERT( uint32_t, double, u32, f64 )
-IMPL_SCALED_CONVERT( int16_t, double, s16, f64 )
-IMPL_SCALED_CONVERT( uint16_t, double, u16, f64 )
-IMPL_SCALED_CONVERT( int8_t, double, s8, f64 )
-IMPL_SCALED_CONVERT( uint8_t, double, u8, f64 )
+#define IMPL_CONVERT_FROM(SRC)                                                                                                      \
+	IMPL_CONVERT( SRC, int8_t )  IMPL_CONVERT( SRC, uint8_t ) IMPL_CONVERT( SRC, int16_t )                                          \
+	IMPL_CONVERT( SRC, uint16_t ) IMPL_CONVERT( SRC, int32_t ) IMPL_CONVERT( SRC, uint32_t )                                        \
+	IMPL_CONVERT( SRC, int64_t ) IMPL_CONVERT( SRC, uint64_t )                                                                      \
+	IMPL_CONVERT( SRC, float ) IMPL_CONVERT( SRC, double )
+
+IMPL_CONVERT_FROM( int8_t )
+IMPL_CONVERT_FROM( uint8_t )
+IMPL_CONVERT_FROM( int16_t )
+IMPL_CONVERT_FROM( uint16_t )
+IMPL_CONVERT_FROM( int32_t )
+IMPL_CONVERT_FROM( uint32_t )
+IMPL_CONVERT_FROM( int64_t )
+IMPL_CONVERT_FROM( uint64_t )
+IMPL_CONVERT_FROM( float )
+IMPL_CONVERT_FROM( double )
 
+#undef IMPL_CONVERT_FROM
 #undef IMPL_CONVERT
-#undef IMPL_SCALED_CONVERT
 }
-#pragma GCC visibility pop
+API_EXCLUDE_END
+
+template<typename T> CompareResult numeric_compare( const T *a, const T *b, size_t count, compareMode mode, double tolerance, bool stopAtFirst )
+{
+	LOG( Runtime, verbose_info ) << "using " << getSimdName( getSimdLevel() ) << " compare of " << count << " " << ValueArray<T>::staticName();
+	return _internal::numeric_compare_impl( a, b, count, mode, tolerance, stopAtFirst );
 }
+
+#define IMPL_COMPARE(TYPE) template CompareResult numeric_compare<TYPE>( const TYPE *a, const TYPE *b, size_t count, compareMode mode, double tolerance, bool stopAtFirst );
+IMPL_COMPARE( int8_t ) IMPL_COMPARE( uint8_t ) IMPL_COMPARE( int16_t ) IMPL_COMPARE( uint16_t ) IMPL_COMPARE( int32_t ) IMPL_COMPARE( uint32_t )
+IMPL_COMPARE( int64_t ) IMPL_COMPARE( uint64_t ) IMPL_COMPARE( float ) IMPL_COMPARE( double )
+#undef IMPL_COMPARE
+
+simdLevel getSimdLevel()
+{
+	static const simdLevel level = _internal::detectSimdLevel();
+	return level;
 }
-#endif //ISIS_USE_LIBOIL
 
+const char *getSimdName( simdLevel level )
+{
+	static const char *names[] = {"none", "sse2", "avx2", "avx512"};
+	return names[level];
+}
+}
+}
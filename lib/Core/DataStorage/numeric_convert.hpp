@@ -14,15 +14,44 @@ namespace isis
 namespace data
 {
 enum autoscaleOption;
+
+/// the instruction set used by the numeric kernels (conversion, min/max) (determined at runtime)
+enum simdLevel {simd_none = 0, simd_sse2, simd_avx2, simd_avx512};
+
+/**
+ * Get the best instruction set usable for numeric conversions and min/max on this machine.
+ * The result is determined once by asking the cpu (and thus the operating system) for the supported instruction sets.
+ * It can be capped by setting the environment variable ISIS_SIMD to one of "none", "sse2", "avx2" or "avx512".
+ */
+simdLevel getSimdLevel();
+/// \returns the name of the given simdLevel (e.g. "avx2")
+const char *getSimdName( simdLevel level );
+
 API_EXCLUDE_BEGIN
 /// @cond _internal
 namespace _internal
 {
 
+// rounding with saturation (values out of the domain of T are clamped, NaN becomes 0)
 template<typename T> T round_impl( double x, boost::mpl::bool_<true> )
 {
-	const double ret( x < 0 ? x - 0.5 : x + 0.5 );
-	return static_cast<T>( ret );
+	const T min = std::numeric_limits<T>::min(), max = std::numeric_limits<T>::max();
+
+	if( std::numeric_limits<T>::digits > std::numeric_limits<double>::digits ) { // max of 64bit-integers is not exact in double
+		if( x != x )
+			return 0;
+		else if( x <= static_cast<double>( min ) )
+			return min;
+		else if( x >= static_cast<double>( max ) )
+			return max;
+		else
+			return static_cast<T>( x < 0 ? x - 0.5 : x + 0.5 );
+	} else { // everything else can be clamped in double (no branches here, so loops using this can be vectorized)
+		x = x < 0 ? x - 0.5 : x + 0.5;
+		x = x < min ? min : x;
+		x = x > max ? max : x;
+		return x == x ? static_cast<T>( x ) : 0;
+	}
 }
 template<typename T> T round_impl( double x, boost::mpl::bool_<false> )
 {
@@ -34,6 +63,26 @@ template<typename T> T round( double x )
 	return round_impl<T>( x, boost::mpl::bool_<std::numeric_limits<T>::is_integer>() ); //we do use overloading intead of (forbidden) partial specialization
 }
 
+// saturating conversion between integers (does not take the detour via double, so 64bit values stay exact)
+template<typename SRC, typename DST> DST saturate_impl( SRC x, boost::mpl::bool_<true> )
+{
+	const bool negative = std::numeric_limits<SRC>::is_signed && x < 0;
+	const bool too_small = negative && ( !std::numeric_limits<DST>::is_signed || static_cast<int64_t>( x ) < static_cast<int64_t>( std::numeric_limits<DST>::min() ) );
+	const bool too_big = !negative && static_cast<uint64_t>( x ) > static_cast<uint64_t>( std::numeric_limits<DST>::max() );
+	return too_small ? std::numeric_limits<DST>::min() : ( too_big ? std::numeric_limits<DST>::max() : static_cast<DST>( x ) );
+}
+template<typename SRC, typename DST> DST saturate_impl( SRC x, boost::mpl::bool_<false> )
+{
+	return round<DST>( x );
+}
+/// convert a single value without scaling (rounding and saturating if DST is an integer)
+template<typename SRC, typename DST> DST saturate( SRC x )
+{
+	return saturate_impl<SRC, DST>( x, boost::mpl::bool_ < std::numeric_limits<SRC>::is_integer && std::numeric_limits<DST>::is_integer > () );
+}
+
+API_EXCLUDE_END // numeric_convert_impl is called by the public numeric_convert, so it must be visible outside of the library
+
 template<typename SRC, typename DST> void numeric_convert_impl( const SRC *src, DST *dst, size_t count, double scale, double offset )
 {
 	LOG( Runtime, info )
@@ -50,7 +99,7 @@ template<typename SRC, typename DST> void numeric_convert_impl( const SRC *src,
 	LOG( Runtime, info ) << "using generic convert " << ValueArray<SRC>::staticName() << " => " << ValueArray<DST>::staticName() << " without scaling";
 
 	for ( size_t i = 0; i < count; i++ )
-		dst[i] = round<DST>( src[i] );
+		dst[i] = saturate<SRC, DST>( src[i] );
 }
 template<typename SRC, typename DST> void numeric_convert_impl( const std::complex<SRC> *src, std::complex<DST> *dst, size_t count, double /*scale*/, double /*offset*/ )
 {
@@ -71,126 +120,32 @@ template<typename T> void numeric_copy_impl( const T *src, T *dst, size_t count,
 		dst[i] = src[i] * scale + offset;
 }
 
-#ifdef ISIS_USE_LIBOIL
-#define DECL_CONVERT(SRC_TYPE,DST_TYPE)        template<> void numeric_convert_impl<SRC_TYPE,DST_TYPE>( const SRC_TYPE *src, DST_TYPE *dst, size_t count )
-#define DECL_SCALED_CONVERT(SRC_TYPE,DST_TYPE) template<> void numeric_convert_impl<SRC_TYPE,DST_TYPE>( const SRC_TYPE *src, DST_TYPE *dst, size_t count, double scale, double offset )
+// the conversions between all numeric types are implemented (and dispatched to the best instruction set) in numeric_convert.cpp
+#define DECL_CONVERT(SRC_TYPE,DST_TYPE)                                                                                                   \
+	template<> void numeric_convert_impl<SRC_TYPE,DST_TYPE>( const SRC_TYPE *src, DST_TYPE *dst, size_t count );                             \
+	template<> void numeric_convert_impl<SRC_TYPE,DST_TYPE>( const SRC_TYPE *src, DST_TYPE *dst, size_t count, double scale, double offset );
 // storage class for explicit specilisations is not allowed (http://www.open-std.org/jtc1/sc22/wg21/docs/cwg_defects.html#605)
 
-//>>s32
-DECL_CONVERT( float, int32_t );
-DECL_CONVERT( double, int32_t );
-DECL_CONVERT( uint32_t, int32_t );
-DECL_CONVERT( int16_t, int32_t );
-DECL_CONVERT( uint16_t, int32_t );
-DECL_CONVERT( int8_t, int32_t );
-DECL_CONVERT( uint8_t, int32_t );
-
-//>>u32
-//DECL_CONVERT(float,uint32_t); conversion to u32 is broken (https://bugs.freedesktop.org/show_bug.cgi?ID=16524)
-//DECL_CONVERT(double,uint32_t);
-DECL_CONVERT( int32_t, uint32_t );
-//DECL_CONVERT(int16_t,uint32_t); ** Not available in liboil - but should be imho
-DECL_CONVERT( uint16_t, uint32_t );
-//DECL_CONVERT(int8_t,uint32_t); ** Not available in liboil - but should be imho
-DECL_CONVERT( uint8_t, uint32_t );
-
-//>>s16
-DECL_CONVERT( float, int16_t );
-DECL_CONVERT( double, int16_t );
-DECL_CONVERT( int32_t, int16_t );
-DECL_CONVERT( uint32_t, int16_t );
-DECL_CONVERT( uint16_t, int16_t );
-DECL_CONVERT( int8_t, int16_t );
-DECL_CONVERT( uint8_t, int16_t );
-
-//>>u16
-DECL_CONVERT( float, uint16_t );
-DECL_CONVERT( double, uint16_t );
-DECL_CONVERT( int32_t, uint16_t );
-DECL_CONVERT( uint32_t, uint16_t );
-DECL_CONVERT( int16_t, uint16_t );
-//DECL_CONVERT(int8_t,uint16_t); ** Not available in liboil - but should be imho
-DECL_CONVERT( uint8_t, uint16_t );
-
-//>>s8
-DECL_CONVERT( float, int8_t );
-DECL_CONVERT( double, int8_t );
-DECL_CONVERT( int32_t, int8_t );
-DECL_CONVERT( uint32_t, int8_t );
-DECL_CONVERT( int16_t, int8_t );
-DECL_CONVERT( uint16_t, int8_t );
-DECL_CONVERT( uint8_t, int8_t );
-
-//>>u8
-DECL_CONVERT( float, uint8_t );
-DECL_CONVERT( double, uint8_t );
-DECL_CONVERT( int32_t, uint8_t );
-DECL_CONVERT( uint32_t, uint8_t );
-DECL_CONVERT( int16_t, uint8_t );
-DECL_CONVERT( uint16_t, uint8_t );
-DECL_CONVERT( int8_t, uint8_t );
-
-//>>f32
-DECL_CONVERT( double, float );
-DECL_CONVERT( int32_t, float );
-DECL_CONVERT( uint32_t, float );
-DECL_CONVERT( int16_t, float );
-DECL_CONVERT( uint16_t, float );
-DECL_CONVERT( int8_t, float );
-DECL_CONVERT( uint8_t, float );
-
-//>>f64
-DECL_CONVERT( float, double );
-DECL_CONVERT( int32_t, double );
-DECL_CONVERT( uint32_t, double );
-DECL_CONVERT( int16_t, double );
-DECL_CONVERT( uint16_t, double );
-DECL_CONVERT( int8_t, double );
-DECL_CONVERT( uint8_t, double );
-
-//scale>>s32
-DECL_SCALED_CONVERT( float, int32_t );
-DECL_SCALED_CONVERT( double, int32_t );
-
-//scale>>u32
-//DECL_SCALED_CONVERT(float,uint32_t); conversion to u32 is broken (https://bugs.freedesktop.org/show_bug.cgi?ID=16524)
-//DECL_SCALED_CONVERT(double,uint32_t);
-
-//scale>>s16
-DECL_SCALED_CONVERT( float, int16_t );
-DECL_SCALED_CONVERT( double, int16_t );
-
-//scale>>u16
-DECL_SCALED_CONVERT( float, uint16_t );
-DECL_SCALED_CONVERT( double, uint16_t );
-
-//scale>>s8
-DECL_SCALED_CONVERT( float, int8_t );
-DECL_SCALED_CONVERT( double, int8_t );
-
-//scale>>u8
-DECL_SCALED_CONVERT( float, uint8_t );
-DECL_SCALED_CONVERT( double, uint8_t );
-
-//scale>>f32
-DECL_SCALED_CONVERT( int32_t, float );
-DECL_SCALED_CONVERT( uint32_t, float );
-DECL_SCALED_CONVERT( int16_t, float );
-DECL_SCALED_CONVERT( uint16_t, float );
-DECL_SCALED_CONVERT( int8_t, float );
-DECL_SCALED_CONVERT( uint8_t, float );
-
-//scale>>f64
-DECL_SCALED_CONVERT( int32_t, double );
-DECL_SCALED_CONVERT( uint32_t, double );
-DECL_SCALED_CONVERT( int16_t, double );
-DECL_SCALED_CONVERT( uint16_t, double );
-DECL_SCALED_CONVERT( int8_t, double );
-DECL_SCALED_CONVERT( uint8_t, double );
-
+#define DECL_CONVERT_FROM(SRC_TYPE)                                                                   \
+	DECL_CONVERT( SRC_TYPE, int8_t )  DECL_CONVERT( SRC_TYPE, uint8_t ) DECL_CONVERT( SRC_TYPE, int16_t ) \
+	DECL_CONVERT( SRC_TYPE, uint16_t ) DECL_CONVERT( SRC_TYPE, int32_t ) DECL_CONVERT( SRC_TYPE, uint32_t ) \
+	DECL_CONVERT( SRC_TYPE, int64_t ) DECL_CONVERT( SRC_TYPE, uint64_t )                                    \
+	DECL_CONVERT( SRC_TYPE, float ) DECL_CONVERT( SRC_TYPE, double )
+
+DECL_CONVERT_FROM( int8_t )
+DECL_CONVERT_FROM( uint8_t )
+DECL_CONVERT_FROM( int16_t )
+DECL_CONVERT_FROM( uint16_t )
+DECL_CONVERT_FROM( int32_t )
+DECL_CONVERT_FROM( uint32_t )
+DECL_CONVERT_FROM( int64_t )
+DECL_CONVERT_FROM( uint64_t )
+DECL_CONVERT_FROM( float )
+DECL_CONVERT_FROM( double )
+
+#undef DECL_CONVERT_FROM
 #undef DECL_CONVERT
-#undef DECL_SCALED_CONVERT
-#endif //ISIS_USE_LIBOIL
+API_EXCLUDE_BEGIN
 
 }
 /// @endcond _internal
@@ -284,7 +239,9 @@ getNumericScaling( const util::ValueBase &min, const util::ValueBase &max, autos
  * - if destination is floating point no scaling is done at all.
  * If dst is shorter than src, no conversion is done.
  * If src is shorter than dst a warning is send to CoreLog.
- * The conversion itself is equivalent to dst[i] = round( src[i] * scale + offset )
+ * The conversion itself is equivalent to dst[i] = round( src[i] * scale + offset ).
+ * If dst is an integer type, values outside of its domain are saturated (clamped to its min/max) and NaN becomes 0.
+ * The loop is run using the best instruction set the cpu supports (see getSimdLevel()).
  * \param src data to be converted
  * \param dst target where to convert src to
  * \param size the amount of elements to be converted
@@ -303,6 +260,20 @@ template<typename T> void numeric_copy( const T *src, T *dst, size_t size )
 	_internal::numeric_copy_impl<T>( src, dst, size );
 }
 
+/**
+ * Compare two arrays of scalar numbers.
+ * The loop is run using the best instruction set the cpu supports (see getSimdLevel()).
+ * This is implemented for all scalar number types (int8_t to uint64_t, float and double).
+ * \param a the first array
+ * \param b the second array
+ * \param count the amount of elements to be compared
+ * \param mode how values are checked for being different (see compareMode)
+ * \param tolerance the allowed absolute or relative difference (ignored for compare_exact)
+ * \param stopAtFirst stop comparing shortly after the first difference was found (see ValueArrayBase::compare)
+ * \returns the result of the comparison (CompareResult::first is relative to a and b)
+ */
+template<typename T> CompareResult numeric_compare( const T *a, const T *b, size_t count, compareMode mode, double tolerance, bool stopAtFirst );
+
 }
 }
 
@@ -0,0 +1,112 @@
+//
+//  prefetcher.cpp
+//  isis
+//
+
+#include "prefetcher.hpp"
+#include "common.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <algorithm>
+#include <boost/lexical_cast.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/once.hpp>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace isis
+{
+namespace data
+{
+
+FilePrefetcher::FilePrefetcher( const std::vector<boost::filesystem::path> &files, size_t depth ): m_files( files ), m_depth( depth ), m_issued( 0 ) {}
+
+void FilePrefetcher::advance( size_t idx )
+{
+	size_t start, end;
+	{
+		const boost::mutex::scoped_lock lock( m_mutex );
+		start = std::max( m_issued, idx + 1 ); // the file at idx is read by its loader anyway
+		end = std::min( idx + 1 + m_depth, m_files.size() );
+
+		if( start >= end )
+			return;
+
+		m_issued = end;
+	}
+
+	for( size_t i = start; i < end; i++ ) // concurrent calls get disjoint ranges, so this doesn't need the lock
+		prefetch( m_files[i] );
+}
+
+size_t FilePrefetcher::getIssued()const
+{
+	const boost::mutex::scoped_lock lock( m_mutex );
+	return m_issued;
+}
+
+void FilePrefetcher::prefetch( const boost::filesystem::path &filename )
+{
+#ifndef WIN32
+	boost::system::error_code err;
+
+	if( !boost::filesystem::is_regular_file( filename, err ) ) // directories are read ahead file by file when they are loaded
+		return;
+
+	const int file = open( filename.native().c_str(), O_RDONLY );
+
+	if( file == -1 ) { // the loader will complain about that if needed
+		LOG( Debug, verbose_info ) << "Not reading ahead " << util::MSubject( filename ) << ", it cannot be opened (" << strerror( errno ) << ")";
+		return;
+	}
+
+	// the kernel starts reading the file and returns, the pages stay in the page cache after the file is closed
+#if defined( POSIX_FADV_WILLNEED )
+	const int failed = posix_fadvise( file, 0, 0, POSIX_FADV_WILLNEED );
+#elif defined( F_RDADVISE )
+	struct radvisory advice = {0, static_cast<int>( std::min<boost::uintmax_t>( boost::filesystem::file_size( filename ), 0x7fffffff ) )};
+	const int failed = fcntl( file, F_RDADVISE, &advice ) == -1 ? errno : 0;
+#else
+	const int failed = 0;
+#endif
+	LOG_IF( failed, Debug, info ) << "Reading ahead " << util::MSubject( filename ) << " failed (" << strerror( failed ) << ")";
+	::close( file );
+#endif
+}
+
+namespace
+{
+boost::once_flag default_depth_once = BOOST_ONCE_INIT;
+boost::atomic<size_t> default_depth( 4 );
+
+void readDefaultDepthFromEnv()
+{
+	const char *env = getenv( "ISIS_PREFETCH" );
+
+	if( env ) {
+		try {
+			default_depth = boost::lexical_cast<size_t>( env );
+		} catch( const boost::bad_lexical_cast & ) {
+			LOG( Runtime, warning ) << "Ignoring invalid value " << util::MSubject( env ) << " of ISIS_PREFETCH";
+		}
+	}
+}
+}
+void FilePrefetcher::setDefaultDepth( size_t depth )
+{
+	boost::call_once( default_depth_once, readDefaultDepthFromEnv ); // so the environment won't overwrite it later
+	default_depth = depth;
+}
+size_t FilePrefetcher::getDefaultDepth()
+{
+	boost::call_once( default_depth_once, readDefaultDepthFromEnv );
+	return default_depth;
+}
+
+}
+}
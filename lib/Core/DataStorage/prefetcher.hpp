@@ -0,0 +1,62 @@
+//
+//  prefetcher.hpp
+//  isis
+//
+
+#ifndef PREFETCHER_HPP
+#define PREFETCHER_HPP
+
+#define BOOST_FILESYSTEM_VERSION 3
+#include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <vector>
+
+namespace isis
+{
+namespace data
+{
+/**
+ * Reads ahead a list of files which are loaded one after another.
+ * When the loading of a file starts (see advance()), the operating system is told to read the next files of the list into the page cache.
+ * The reading is done by the kernel in the background, so the disk is busy while the current file is parsed, and the loaders find the next files already in memory.
+ * This works for all loaders, no matter if they map the file (FilePtr) or read it through their own library (e.g. dcmtk).
+ *
+ * No threads are involved, so advance() is cheap and can be called from the jobs loading the files in parallel.
+ * On platforms which cannot read ahead asynchronously this does nothing.
+ */
+class FilePrefetcher: boost::noncopyable
+{
+	std::vector<boost::filesystem::path> m_files;
+	size_t m_depth, m_issued;
+	mutable boost::mutex m_mutex;
+	static void prefetch( const boost::filesystem::path &filename );
+public:
+	/**
+	 * Create a prefetcher for the given files.
+	 * Nothing is read before advance() is called first.
+	 * \param files the files in the order they are going to be loaded
+	 * \param depth how many files are read ahead of the file currently loaded (see getDefaultDepth)
+	 */
+	FilePrefetcher( const std::vector<boost::filesystem::path> &files, size_t depth = getDefaultDepth() );
+	/**
+	 * Tell the prefetcher that the file with the given index is loaded now.
+	 * The files up to idx+depth, which were not read ahead already, are read ahead.
+	 * \param idx the index of the file in the list given to the constructor
+	 */
+	void advance( size_t idx );
+	/// \returns the number of files from the start of the list which were read ahead (or loaded) already
+	size_t getIssued()const;
+
+	/**
+	 * Set how many files are read ahead by default.
+	 * Initially this is read from the environment variable ISIS_PREFETCH, and 4 if that is not set. 0 disables the prefetching.
+	 */
+	static void setDefaultDepth( size_t depth );
+	/// \returns how many files are read ahead by default
+	static size_t getDefaultDepth();
+};
+}
+}
+
+#endif // PREFETCHER_HPP
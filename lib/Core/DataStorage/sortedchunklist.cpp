@@ -21,6 +21,7 @@
 #endif
 
 #include "sortedchunklist.hpp"
+#include <boost/functional/hash.hpp>
 
 /// @cond _internal
 namespace isis
@@ -33,7 +34,22 @@ namespace _internal
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // sorting algorithm implementation
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-SortedChunkList::scalarPropCompare::scalarPropCompare( const util::PropertyMap::KeyType &prop_name ): propertyName( prop_name ) {}
+SortedChunkList::scalarPropCompare::scalarPropCompare( const util::PropertyMap::KeyType &prop_name ): propertyName( prop_name ), propertyPath( prop_name ) {}
+
+SortedChunkList::ChunkGeometry::ChunkGeometry( const Chunk &ch )
+{
+	static const util::PropertyMap::PropPath rowVecProb( "rowVec" ), columnVecProb( "columnVec" ), sliceVecProb( "sliceVec" ), indexOriginProb( "indexOrigin" );
+	indexOrigin = ch.propertyValue( indexOriginProb ).castTo<util::fvector3>();
+	rowVec = ch.propertyValue( rowVecProb ).castTo<util::fvector3>();
+	columnVec = ch.propertyValue( columnVecProb ).castTo<util::fvector3>();
+	sliceVec = ch.hasProperty( sliceVecProb ) ?
+			   ch.propertyValue( sliceVecProb ).castTo<util::fvector3>() :
+			   util::fvector3(
+				   rowVec[1] * columnVec[2] - rowVec[2] * columnVec[1],
+				   rowVec[2] * columnVec[0] - rowVec[0] * columnVec[2],
+				   rowVec[0] * columnVec[1] - rowVec[1] * columnVec[0]
+			   );
+}
 
 bool SortedChunkList::posCompare::operator()( const util::fvector3 &posA, const util::fvector3 &posB ) const
 {
@@ -56,6 +72,41 @@ bool SortedChunkList::scalarPropCompare::operator()( const isis::util::PropertyV
 		return false;
 }
 
+namespace
+{
+template<typename T> bool hashAs( const util::ValueBase &val, size_t &seed )
+{
+	if( val.is<T>() ) {
+		boost::hash_combine( seed, val.castTo<T>() );
+		return true;
+	} else
+		return false;
+}
+template<typename T> bool hashVectorAs( const util::ValueBase &val, size_t &seed )
+{
+	if( val.is<T>() ) {
+		const T &vec = val.castTo<T>();
+		boost::hash_range( seed, vec.begin(), vec.end() );
+		return true;
+	} else
+		return false;
+}
+// values of different types are never equal (see util::Value::operator==), so the type is part of the hash
+size_t hashValue( const util::ValueBase &val )
+{
+	size_t seed = val.getTypeID();
+
+	// floating point values are hashed directly, so equal values like -0 and 0 get the same hash
+	if( !( hashAs<float>( val, seed ) || hashAs<double>( val, seed ) ||
+		   hashVectorAs<util::fvector3>( val, seed ) || hashVectorAs<util::dvector3>( val, seed ) ||
+		   hashVectorAs<util::fvector4>( val, seed ) || hashVectorAs<util::dvector4>( val, seed ) )
+	  )
+		boost::hash_combine( seed, val.toString( false ) );
+
+	return seed;
+}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Chunk operators
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -89,11 +140,11 @@ SortedChunkList::SecondaryMap *SortedChunkList::primaryFind( const util::fvector
 // low level insert
 std::pair<boost::shared_ptr<Chunk>, bool> SortedChunkList::secondaryInsert( SecondaryMap &map, const Chunk &ch )
 {
-	util::PropertyMap::KeyType propName = map.key_comp().propertyName;
+	const util::PropertyMap::PropPath &propPath = map.key_comp().propertyPath;
 
-	if( ch.hasProperty( propName ) ) {
+	if( ch.hasProperty( propPath ) ) {
 		//check, if there is already a chunk
-		boost::shared_ptr<Chunk> &pos = map[ch.propertyValue( propName )];
+		boost::shared_ptr<Chunk> &pos = map[ch.propertyValue( propPath )];
 		bool inserted = false;
 
 		//if not. put oures there
@@ -105,40 +156,31 @@ std::pair<boost::shared_ptr<Chunk>, bool> SortedChunkList::secondaryInsert( Seco
 		assert( pos ); // here it must have some content
 		return std::make_pair( pos, inserted );
 	} else {
-		LOG( Runtime, warning ) << "Cannot insert chunk. It's lacking the property " << util::MSubject( propName ) << " which is needed for primary sorting";
+		LOG( Runtime, warning ) << "Cannot insert chunk. It's lacking the property " << util::MSubject( propPath ) << " which is needed for primary sorting";
 		return std::pair<boost::shared_ptr<Chunk>, bool>( boost::shared_ptr<Chunk>(), false );
 	}
 }
 std::pair<boost::shared_ptr<Chunk>, bool> SortedChunkList::primaryInsert( const Chunk &ch )
 {
-	static const util::PropertyMap::PropPath rowVecProb( "rowVec" ), columnVecProb( "columnVec" ), sliceVecProb( "sliceVec" ), indexOriginProb( "indexOrigin" );
 	LOG_IF( secondarySort.empty(), Debug, error ) << "There is no known secondary sorting left. Chunksort will fail.";
 	assert( ch.isValid() );
 	// compute the position of the chunk in the image space
 	// we dont have this position, but we have the position in scanner-space (indexOrigin)
-	const util::fvector3 &origin = ch.propertyValue( indexOriginProb ).castTo<util::fvector3>();
 	// and we have the transformation matrix
 	// [ rowVec ]
 	// [ columnVec]
 	// [ sliceVec]
 	// [ 0 0 0 1 ]
-	const util::fvector3 &rowVec = ch.propertyValue( rowVecProb ).castTo<util::fvector3>();
-	const util::fvector3 &columnVec = ch.propertyValue( columnVecProb ).castTo<util::fvector3>();
-	const util::fvector3 sliceVec = ch.hasProperty( sliceVecProb ) ?
-									ch.propertyValue( sliceVecProb ).castTo<util::fvector3>() :
-									util::fvector3(
-										rowVec[1] * columnVec[2] - rowVec[2] * columnVec[1],
-										rowVec[2] * columnVec[0] - rowVec[0] * columnVec[2],
-										rowVec[0] * columnVec[1] - rowVec[1] * columnVec[0]
-									);
-
+	const ChunkGeometry geo( ch );
 
 	// this is actually not the complete transform (it lacks the scaling for the voxel size), but its enough
-	const util::fvector3 key( origin.dot( rowVec ), origin.dot( columnVec ), origin.dot( sliceVec ) );
+	const util::fvector3 key( geo.indexOrigin.dot( geo.rowVec ), geo.indexOrigin.dot( geo.columnVec ), geo.indexOrigin.dot( geo.sliceVec ) );
 	const scalarPropCompare &secondaryComp = secondarySort.top();
 
 	// get the reference of the secondary map for "key" (create and insert a new if neccessary)
 	SecondaryMap &subMap = chunks.insert( std::make_pair( key, SecondaryMap( secondaryComp ) ) ).first->second;
+	geometry.insert( std::make_pair( key, geo ) );
+	geometryLookup.clear();
 
 	// run insert on that
 	return secondaryInsert( subMap, ch ); // insert ch into the right secondary map
@@ -175,7 +217,7 @@ bool SortedChunkList::insert( const Chunk &ch )
 		LOG( Debug, verbose_info ) << "Inserting 1st chunk";
 		std::stack<scalarPropCompare> backup = secondarySort;
 
-		while( !ch.hasProperty( secondarySort.top().propertyName ) ) {
+		while( !ch.hasProperty( secondarySort.top().propertyPath ) ) {
 			const util::PropertyMap::KeyType temp = secondarySort.top().propertyName;
 
 			if ( secondarySort.size() > 1 ) {
@@ -220,6 +262,8 @@ bool SortedChunkList::isEmpty()const
 void SortedChunkList::clear()
 {
 	chunks.clear();
+	geometry.clear();
+	geometryLookup.clear();
 }
 bool SortedChunkList::isRectangular()
 {
@@ -240,6 +284,18 @@ size_t SortedChunkList::getHorizontalSize()
 	else return chunks.begin()->second.size();
 }
 
+size_t SortedChunkList::getEqualityHash( const Chunk &ch )const
+{
+	const util::vector4<size_t> size = ch.getSizeAsVector();
+	size_t seed = boost::hash_range( size.begin(), size.end() );
+
+	BOOST_FOREACH( const util::PropertyMap::PropPath & ref, equalProps ) {
+		// chunks lacking a property can only be together with others lacking it (see insert)
+		boost::hash_combine( seed, ch.hasProperty( ref ) ? hashValue( *ch.propertyValue( ref ) ) : 0 );
+	}
+	return seed;
+}
+
 std::vector< boost::shared_ptr< Chunk > > SortedChunkList::getLookup()
 {
 	LOG_IF( !isRectangular(), Debug, error ) << "Running getLookup on an non rectangular chunk-list is not defined";
@@ -265,6 +321,29 @@ std::vector< boost::shared_ptr< Chunk > > SortedChunkList::getLookup()
 		return std::vector< boost::shared_ptr< Chunk > >();
 }
 
+const std::vector<SortedChunkList::ChunkGeometry> &SortedChunkList::getGeometryLookup()
+{
+	if( geometryLookup.empty() && !isEmpty() ) {
+		const size_t vertical = chunks.begin()->second.size();
+		geometryLookup.reserve( geometry.size() * vertical );
+
+		for( size_t v = 0; v < vertical; v++ ) // all chunks at the same primary position share its geometry
+			for( std::map<util::fvector3, ChunkGeometry, posCompare>::const_iterator i = geometry.begin(); i != geometry.end(); i++ )
+				geometryLookup.push_back( i->second );
+	}
+
+	return geometryLookup;
+}
+void SortedChunkList::updateGeometry()
+{
+	for( PrimaryMap::const_iterator i = chunks.begin(); i != chunks.end(); i++ ) {
+		if( !i->second.empty() ) // all chunks at the same primary position share its geometry
+			geometry.find( i->first )->second = ChunkGeometry( *i->second.begin()->second );
+	}
+
+	geometryLookup.clear();
+}
+
 void SortedChunkList::transform( chunkPtrOperator &op )
 {
 	BOOST_FOREACH( PrimaryMap::reference outer, chunks ) {
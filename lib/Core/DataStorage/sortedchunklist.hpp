@@ -42,12 +42,22 @@ class SortedChunkList
 public:
 	struct scalarPropCompare {
 		util::PropertyMap::KeyType propertyName;
+		util::PropertyMap::PropPath propertyPath; // parsed once, so inserting doesn't have to
 		scalarPropCompare( const util::PropertyMap::KeyType &prop_name );
 		bool operator()( const util::PropertyValue &a, const util::PropertyValue &b ) const;
 	};
 	struct posCompare {
 		bool operator()( const util::fvector3 &a, const util::fvector3 &b ) const;
 	};
+	/**
+	 * The geometric properties of a chunk.
+	 * They are read once when the chunk is inserted, so sorting and indexing don't have to look them up in the PropertyMap again.
+	 * If the chunks are moved after that, they have to be read again (see updateGeometry).
+	 */
+	struct ChunkGeometry {
+		util::fvector3 indexOrigin, rowVec, columnVec, sliceVec;
+		ChunkGeometry( const Chunk &ch );
+	};
 	struct chunkPtrOperator {
 		virtual boost::shared_ptr<Chunk> operator()( const boost::shared_ptr<Chunk> &ptr ) = 0;
 		virtual ~chunkPtrOperator();
@@ -59,6 +69,8 @@ private:
 	std::stack<scalarPropCompare> secondarySort;
 	posCompare primarySort;
 	PrimaryMap chunks;
+	std::map<util::fvector3, ChunkGeometry, posCompare> geometry; // geometry of the chunks at each primary position
+	std::vector<ChunkGeometry> geometryLookup; // geometry in the order of getLookup (made by getGeometryLookup, cleared whenever chunks are inserted or the geometry is updated)
 
 	// low level finding
 	boost::shared_ptr<Chunk> secondaryFind( const util::PropertyValue &key, SecondaryMap &map );
@@ -99,12 +111,26 @@ public:
 
 	/// \returns a ordered vector of pointers to the chunks in the list
 	std::vector<boost::shared_ptr<Chunk> > getLookup();
+	/// \returns the geometry of the chunks in the same order as getLookup (valid until the list is changed)
+	const std::vector<ChunkGeometry> &getGeometryLookup();
+	/**
+	 * Read the geometry of the chunks again.
+	 * This has to be done if the geometric properties of the chunks in the list were changed (e.g. by Chunk::transformCoords).
+	 * The chunks are not sorted again.
+	 */
+	void updateGeometry();
 
 	/// \returns true if the list is rectangular (the amount of secondary sorted entries is equal across all primary entries)
 	bool isRectangular();
 
 	/// \returns the amount secondary sorted entries
 	size_t getHorizontalSize();
+
+	/**
+	 * Computes a hash of everything which has to be equal across the list (the size and the properties given to the constructor).
+	 * Chunks which could be inserted into the same list always get the same hash.
+	 */
+	size_t getEqualityHash( const Chunk &ch )const;
 };
 
 
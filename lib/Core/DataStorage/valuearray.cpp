@@ -1,4 +1,10 @@
 #include "valuearray.hpp"
+#include "numeric_convert.hpp"
+#include "../CoreUtils/threadpool.hpp"
+
+#if ISIS_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
 
 namespace isis
 {
@@ -15,14 +21,48 @@ template<> scaling_pair ValueArray<std::complex<double> >::getScalingTo( unsigne
 	return scaling_pair( util::Value<double>( 1 ), util::Value<double>( 0 ) );
 }
 
-#ifdef __SSE2__
-
-#include <emmintrin.h>
 namespace _internal
 {
 
 API_EXCLUDE_BEGIN
 
+/////////////////////////////////////////////////
+// scalar min/max (same rules as calcMinMax)    /
+/////////////////////////////////////////////////
+
+// the lowest value of T (for types with denormalization min is _not_ the lowest value)
+template<typename T> T _lowest()
+{
+	return std::numeric_limits<T>::has_denorm ? -std::numeric_limits<T>::max() : std::numeric_limits<T>::min();
+}
+
+// skips +/-inf and NaN like the generic calcMinMax
+template<typename T> void _accumulateMinMax( const T *begin, const T *end, std::pair<T, T> &result )
+{
+	for ( const T *i = begin; i < end; i++ ) {
+		if(
+			std::numeric_limits<T>::has_infinity &&
+			( *i == std::numeric_limits<T>::infinity() || *i == -std::numeric_limits<T>::infinity() )
+		)
+			continue;
+
+		if ( *i > result.second )result.second = *i;
+
+		if ( *i < result.first )result.first = *i;
+	}
+}
+
+template<typename T> std::pair<T, T> _getMinMaxScalar( const T *data, size_t len )
+{
+	std::pair<T, T> ret( std::numeric_limits<T>::max(), _lowest<T>() );
+	_accumulateMinMax( data, data + len, ret );
+	return ret;
+}
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
 ///////////////////////////////////////////////////////////
 // some voodoo to get the vector types into the templates /
 //////////////////////////////////////////////////////////
@@ -76,7 +116,6 @@ DEF_VECTOR_UI( uint32_t, 32 );
 template<typename T> std::pair<__m128i, __m128i> _getMinMaxBlockLoop( const __m128i *data, size_t blocks )
 {
 	std::pair<__m128i, __m128i> ret( _mm_loadu_si128( data ), _mm_loadu_si128( data ) );
-	LOG( Runtime, verbose_info ) << "using optimized min/max computation for " << util::Value<T>::staticName() << " (masked mode)";
 	static const __m128i one = _mm_set_epi16( -1, -1, -1, -1, -1, -1, -1, -1 );
 
 	while ( --blocks ) {
@@ -100,7 +139,6 @@ template<typename T> std::pair<__m128i, __m128i> _getMinMaxBlockLoop( const __m1
 template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<uint8_t>( const __m128i *data, size_t blocks ) //PMAXUB
 {
 	std::pair<__m128i, __m128i> ret( _mm_loadu_si128( data ), _mm_loadu_si128( data ) );
-	LOG( Runtime, verbose_info ) << "using optimized min/max computation for " << util::Value<uint8_t>::staticName() << " (direct mode)";
 
 	while ( --blocks ) {
 		const __m128i at = _mm_loadu_si128( ++data );
@@ -113,7 +151,6 @@ template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<uint8_t>( const __m12
 template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<int16_t>( const __m128i *data, size_t blocks ) //PMAXSW
 {
 	std::pair<__m128i, __m128i> ret( _mm_loadu_si128( data ), _mm_loadu_si128( data ) );
-	LOG( Runtime, verbose_info ) << "using optimized min/max computation for " << util::Value<int16_t>::staticName() << " (direct mode)";
 
 	while ( --blocks ) {
 		const __m128i at = _mm_loadu_si128( ++data );
@@ -129,7 +166,6 @@ template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<int16_t>( const __m12
 template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<int8_t>( const __m128i *data, size_t blocks ) //PMAXSB
 {
 	std::pair<__m128i, __m128i> ret( _mm_loadu_si128( data ), _mm_loadu_si128( data ) );
-	LOG( Runtime, verbose_info ) << "using optimized min/max computation for " << util::Value<int8_t>::staticName() << " (direct mode)";
 
 	while ( --blocks ) {
 		const __m128i at = _mm_loadu_si128( ++data );
@@ -142,7 +178,6 @@ template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<int8_t>( const __m128
 template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<uint16_t>( const __m128i *data, size_t blocks ) //PMAXUW
 {
 	std::pair<__m128i, __m128i> ret( _mm_loadu_si128( data ), _mm_loadu_si128( data ) );
-	LOG( Runtime, verbose_info ) << "using optimized min/max computation for " << util::Value<uint16_t>::staticName() << " (direct mode)";
 
 	while ( --blocks ) {
 		const __m128i at = _mm_loadu_si128( ++data );
@@ -155,7 +190,6 @@ template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<uint16_t>( const __m1
 template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<int32_t>( const __m128i *data, size_t blocks ) //PMAXSD
 {
 	std::pair<__m128i, __m128i> ret( _mm_loadu_si128( data ), _mm_loadu_si128( data ) );
-	LOG( Runtime, verbose_info ) << "using optimized min/max computation for " << util::Value<int32_t>::staticName() << " (direct mode)";
 
 	while ( --blocks ) {
 		const __m128i at = _mm_loadu_si128( ++data );
@@ -168,7 +202,6 @@ template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<int32_t>( const __m12
 template<> std::pair<__m128i, __m128i> _getMinMaxBlockLoop<uint32_t>( const __m128i *data, size_t blocks ) //PMAXSD
 {
 	std::pair<__m128i, __m128i> ret( _mm_loadu_si128( data ), _mm_loadu_si128( data ) );
-	LOG( Runtime, verbose_info ) << "using optimized min/max computation for " << util::Value<uint32_t>::staticName() << " (direct mode)";
 
 	while ( --blocks ) {
 		const __m128i at = _mm_loadu_si128( ++data );
@@ -206,25 +239,211 @@ template<typename T> std::pair<T, T> _getMinMax( const T *data, size_t len )
 	}
 }
 
+#else
+#warning Optimized min/max functions are not used because SSE2 is not enabled
+#endif //__SSE2__
+
+//////////////////////////////////////////////////////////////
+// vectorized min/max for float, double and (u)int64_t       /
+//////////////////////////////////////////////////////////////
+
+// the kernel is the same for all of them, only the vector operations differ
+// non-finite values are replaced by the neutral element of min (max) and max (lowest) respectively
+#define DEF_MINMAX_KERNEL(NAME,ATTRIBUTE,VECTOR)                                                                                    \
+	template<typename T> ATTRIBUTE std::pair<T, T> NAME( const T *data, size_t len ){                                               \
+		typedef VECTOR<T> V;                                                                                                        \
+		const typename V::reg upper = V::set1( std::numeric_limits<T>::max() ), lower = V::set1( _lowest<T>() );                  \
+		typename V::reg vmin = upper, vmax = lower;                                                                                 \
+		size_t i = 0;                                                                                                               \
+		for( ; i + V::width <= len; i += V::width ) {                                                                               \
+			const typename V::reg at = V::load( data + i ), finite = V::finite( at );                                               \
+			vmin = V::min( vmin, V::select( finite, at, upper ) );                                                                  \
+			vmax = V::max( vmax, V::select( finite, at, lower ) );                                                                  \
+		}                                                                                                                           \
+		T mins[V::width], maxs[V::width];                                                                                           \
+		V::store( mins, vmin );                                                                                                     \
+		V::store( maxs, vmax );                                                                                                     \
+		std::pair<T, T> ret( *std::min_element( mins, mins + V::width ), *std::max_element( maxs, maxs + V::width ) );              \
+		_accumulateMinMax( data + i, data + len, ret );                                                                             \
+		return ret;                                                                                                                 \
+	}
+
+#ifdef __SSE2__
+template<typename T> struct _SSE2Vector;
+
+// sub(v,v) is 0 for all finite values and NaN for NaN and +/-inf
+#define DEF_SSE2_FLOAT(TYPE,REG,KEY)                                                                                                \
+	template<> struct _SSE2Vector<TYPE>{                                                                                            \
+		typedef REG reg;                                                                                                            \
+		enum {width = sizeof( REG ) / sizeof( TYPE )};                                                                              \
+		static reg load( const TYPE *p ) {return _mm_loadu_ ## KEY( p );}                                                           \
+		static void store( TYPE *p, reg v ) {_mm_storeu_ ## KEY( p, v );}                                                           \
+		static reg set1( TYPE v ) {return _mm_set1_ ## KEY( v );}                                                                   \
+		static reg min( reg a, reg b ) {return _mm_min_ ## KEY( a, b );}                                                            \
+		static reg max( reg a, reg b ) {return _mm_max_ ## KEY( a, b );}                                                            \
+		static reg finite( reg v ) {return _mm_cmpeq_ ## KEY( _mm_sub_ ## KEY( v, v ), _mm_setzero_ ## KEY() );}                  \
+		static reg select( reg mask, reg a, reg b ) {return _mm_or_ ## KEY( _mm_and_ ## KEY( mask, a ), _mm_andnot_ ## KEY( mask, b ) );} \
+	}
+DEF_SSE2_FLOAT( float, __m128, ps );
+DEF_SSE2_FLOAT( double, __m128d, pd );
+#undef DEF_SSE2_FLOAT
+
+DEF_MINMAX_KERNEL( _getMinMaxSSE2, ISIS_TARGET_DEFAULT, _SSE2Vector )
+#endif //__SSE2__
+
+#if ISIS_SIMD_DISPATCH
+template<typename T> struct _AVX2Vector;
+
+#define DEF_AVX2_FLOAT(TYPE,REG,KEY)                                                                                                \
+	template<> struct _AVX2Vector<TYPE>{                                                                                            \
+		typedef REG reg;                                                                                                            \
+		enum {width = sizeof( REG ) / sizeof( TYPE )};                                                                              \
+		static ISIS_TARGET_AVX2 reg load( const TYPE *p ) {return _mm256_loadu_ ## KEY( p );}                                       \
+		static ISIS_TARGET_AVX2 void store( TYPE *p, reg v ) {_mm256_storeu_ ## KEY( p, v );}                                       \
+		static ISIS_TARGET_AVX2 reg set1( TYPE v ) {return _mm256_set1_ ## KEY( v );}                                               \
+		static ISIS_TARGET_AVX2 reg min( reg a, reg b ) {return _mm256_min_ ## KEY( a, b );}                                        \
+		static ISIS_TARGET_AVX2 reg max( reg a, reg b ) {return _mm256_max_ ## KEY( a, b );}                                        \
+		static ISIS_TARGET_AVX2 reg finite( reg v ) {return _mm256_cmp_ ## KEY( _mm256_sub_ ## KEY( v, v ), _mm256_setzero_ ## KEY(), _CMP_EQ_OQ );} \
+		static ISIS_TARGET_AVX2 reg select( reg mask, reg a, reg b ) {return _mm256_blendv_ ## KEY( b, a, mask );}                  \
+	}
+DEF_AVX2_FLOAT( float, __m256, ps );
+DEF_AVX2_FLOAT( double, __m256d, pd );
+#undef DEF_AVX2_FLOAT
+
+// there is no min/max for 64bit integers before avx512, so its done via cmpgt (unsigned values are shifted to compare them as signed)
+template<typename T> struct _AVX2Int64 {
+	typedef __m256i reg;
+	enum {width = 4};
+	static ISIS_TARGET_AVX2 reg shift() {return _mm256_set1_epi64x( boost::is_signed<T>::value ? 0 : std::numeric_limits<int64_t>::min() );}
+	static ISIS_TARGET_AVX2 reg load( const T *p ) {return _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i *>( p ) ), shift() );}
+	static ISIS_TARGET_AVX2 void store( T *p, reg v ) {_mm256_storeu_si256( reinterpret_cast<__m256i *>( p ), _mm256_xor_si256( v, shift() ) );}
+	static ISIS_TARGET_AVX2 reg set1( T v ) {return _mm256_xor_si256( _mm256_set1_epi64x( v ), shift() );}
+	static ISIS_TARGET_AVX2 reg min( reg a, reg b ) {return _mm256_blendv_epi8( a, b, _mm256_cmpgt_epi64( a, b ) );}
+	static ISIS_TARGET_AVX2 reg max( reg a, reg b ) {return _mm256_blendv_epi8( a, b, _mm256_cmpgt_epi64( b, a ) );}
+	static ISIS_TARGET_AVX2 reg finite( reg /*v*/ ) {return _mm256_set1_epi64x( -1 );}
+	static ISIS_TARGET_AVX2 reg select( reg mask, reg a, reg b ) {return _mm256_blendv_epi8( b, a, mask );}
+};
+template<> struct _AVX2Vector<int64_t>: _AVX2Int64<int64_t> {};
+template<> struct _AVX2Vector<uint64_t>: _AVX2Int64<uint64_t> {};
+
+DEF_MINMAX_KERNEL( _getMinMaxAVX2, ISIS_TARGET_AVX2, _AVX2Vector )
+#endif //ISIS_SIMD_DISPATCH
+
+#undef DEF_MINMAX_KERNEL
+
+///////////////////////////////////////////////////////////////
+// select the best kernel for the cpu (see getSimdLevel)      /
+///////////////////////////////////////////////////////////////
+
+template<typename T> struct _MinMaxKernel {
+	typedef std::pair<T, T> ( *kernel )( const T *, size_t );
+	static kernel get() {return _getMinMaxScalar<T>;}
+};
+
+#ifdef __SSE2__
+#define DEF_KERNEL_SSE2_INT(TYPE)                                                                                                   \
+	template<> _MinMaxKernel<TYPE>::kernel _MinMaxKernel<TYPE>::get() {                                                             \
+		return getSimdLevel() >= simd_sse2 ? _getMinMax<TYPE> : _getMinMaxScalar<TYPE>;                                            \
+	}
+DEF_KERNEL_SSE2_INT( uint8_t )
+DEF_KERNEL_SSE2_INT( uint16_t )
+DEF_KERNEL_SSE2_INT( uint32_t )
+DEF_KERNEL_SSE2_INT( int8_t )
+DEF_KERNEL_SSE2_INT( int16_t )
+DEF_KERNEL_SSE2_INT( int32_t )
+#undef DEF_KERNEL_SSE2_INT
+#endif //__SSE2__
+
+#if ISIS_SIMD_DISPATCH
+template<> _MinMaxKernel<int64_t>::kernel _MinMaxKernel<int64_t>::get()
+{
+	return getSimdLevel() >= simd_avx2 ? _getMinMaxAVX2<int64_t> : _getMinMaxScalar<int64_t>;
+}
+template<> _MinMaxKernel<uint64_t>::kernel _MinMaxKernel<uint64_t>::get()
+{
+	return getSimdLevel() >= simd_avx2 ? _getMinMaxAVX2<uint64_t> : _getMinMaxScalar<uint64_t>;
+}
+#endif //ISIS_SIMD_DISPATCH
+
+template<typename T> typename _MinMaxKernel<T>::kernel _getFloatKernel()
+{
+#if ISIS_SIMD_DISPATCH
+
+	if( getSimdLevel() >= simd_avx2 )
+		return _getMinMaxAVX2<T>;
+
+#endif
+#ifdef __SSE2__
+
+	if( getSimdLevel() >= simd_sse2 )
+		return _getMinMaxSSE2<T>;
+
+#endif
+	return _getMinMaxScalar<T>;
+}
+template<> _MinMaxKernel<float>::kernel _MinMaxKernel<float>::get() {return _getFloatKernel<float>();}
+template<> _MinMaxKernel<double>::kernel _MinMaxKernel<double>::get() {return _getFloatKernel<double>();}
+
+////////////////////////////////////////////////////////////
+// split big arrays into blocks handled by the thread pool /
+////////////////////////////////////////////////////////////
+
+template<typename T> struct _MinMaxBlock {
+	typename _MinMaxKernel<T>::kernel kernel;
+	const T *data;
+	std::pair<T, T> *results;
+	void operator()( size_t block, size_t start, size_t end )const {
+		results[block] = kernel( data + start, end - start );
+	}
+};
+
+template<typename T> std::pair<T, T> _parallelMinMax( const T *data, size_t len )
+{
+	static const typename _MinMaxKernel<T>::kernel kernel = _MinMaxKernel<T>::get();
+	// blocks must be big enough to outweigh the cost of handing them to another thread
+	const size_t min_block = ( 256 * 1024 ) / sizeof( T );
+	util::ThreadPool &pool = util::ThreadPool::global();
+	const size_t blocks = pool.getBlocks( len, min_block );
+
+	LOG( Runtime, verbose_info ) << "using optimized min/max computation for " << util::Value<T>::staticName() << " in " << blocks << " block(s)";
+
+	if( blocks < 2 )
+		return kernel( data, len );
+
+	std::vector<std::pair<T, T> > results( blocks );
+	const _MinMaxBlock<T> op = {kernel, data, &results[0]};
+	pool.forEachBlock( len, min_block, op );
+
+	std::pair<T, T> ret = results[0];
+
+	for( size_t i = 1; i < blocks; i++ ) {
+		ret.first = std::min( ret.first, results[i].first );
+		ret.second = std::max( ret.second, results[i].second );
+	}
+
+	return ret;
+}
+
 API_EXCLUDE_END
 
-////////////////////////////////////////////////
-// specialize calcMinMax for (u)int(8,16,32)_t /
-////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////
+// specialize calcMinMax for (u)int(8,16,32,64)_t, float, double /
+////////////////////////////////////////////////////////////////
+
+template<> std::pair< uint8_t,  uint8_t> calcMinMax< uint8_t, 1>( const  uint8_t *data, size_t len ) {return _parallelMinMax( data, len );}
+template<> std::pair<uint16_t, uint16_t> calcMinMax<uint16_t, 1>( const uint16_t *data, size_t len ) {return _parallelMinMax( data, len );}
+template<> std::pair<uint32_t, uint32_t> calcMinMax<uint32_t, 1>( const uint32_t *data, size_t len ) {return _parallelMinMax( data, len );}
+template<> std::pair<uint64_t, uint64_t> calcMinMax<uint64_t, 1>( const uint64_t *data, size_t len ) {return _parallelMinMax( data, len );}
 
-template<> std::pair< uint8_t,  uint8_t> calcMinMax< uint8_t, 1>( const  uint8_t *data, size_t len ) {return _getMinMax( data, len );}
-template<> std::pair<uint16_t, uint16_t> calcMinMax<uint16_t, 1>( const uint16_t *data, size_t len ) {return _getMinMax( data, len );}
-template<> std::pair<uint32_t, uint32_t> calcMinMax<uint32_t, 1>( const uint32_t *data, size_t len ) {return _getMinMax( data, len );}
+template<> std::pair< int8_t,  int8_t> calcMinMax< int8_t, 1>( const  int8_t *data, size_t len ) {return _parallelMinMax( data, len );}
+template<> std::pair<int16_t, int16_t> calcMinMax<int16_t, 1>( const int16_t *data, size_t len ) {return _parallelMinMax( data, len );}
+template<> std::pair<int32_t, int32_t> calcMinMax<int32_t, 1>( const int32_t *data, size_t len ) {return _parallelMinMax( data, len );}
+template<> std::pair<int64_t, int64_t> calcMinMax<int64_t, 1>( const int64_t *data, size_t len ) {return _parallelMinMax( data, len );}
 
-template<> std::pair< int8_t,  int8_t> calcMinMax< int8_t, 1>( const  int8_t *data, size_t len ) {return _getMinMax( data, len );}
-template<> std::pair<int16_t, int16_t> calcMinMax<int16_t, 1>( const int16_t *data, size_t len ) {return _getMinMax( data, len );}
-template<> std::pair<int32_t, int32_t> calcMinMax<int32_t, 1>( const int32_t *data, size_t len ) {return _getMinMax( data, len );}
+template<> std::pair<float, float> calcMinMax<float, 1>( const float *data, size_t len ) {return _parallelMinMax( data, len );}
+template<> std::pair<double, double> calcMinMax<double, 1>( const double *data, size_t len ) {return _parallelMinMax( data, len );}
 
 } //namepace _internal
-#else
-#warning Optimized min/max functions are not used because SSE2 is not enabled
-#endif
 /// @endcond
 }
 }
-
@@ -61,19 +61,24 @@ template<typename T, uint8_t STEPSIZE> std::pair<T, T> calcMinMax( const T *data
 	return result;
 }
 
-#ifdef __SSE2__
-////////////////////////////////////////////////
-// specialize calcMinMax for (u)int(8,16,32)_t /
-////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////
+// specialize calcMinMax for (u)int(8,16,32,64)_t, float, double /
+////////////////////////////////////////////////////////////////
+// these are vectorized (if possible) and split big arrays into blocks processed in parallel (see util::ThreadPool)
+// the results are the same as from the generic version above
 
 template<> std::pair< uint8_t,  uint8_t> calcMinMax< uint8_t, 1>( const  uint8_t *data, size_t len );
 template<> std::pair<uint16_t, uint16_t> calcMinMax<uint16_t, 1>( const uint16_t *data, size_t len );
 template<> std::pair<uint32_t, uint32_t> calcMinMax<uint32_t, 1>( const uint32_t *data, size_t len );
+template<> std::pair<uint64_t, uint64_t> calcMinMax<uint64_t, 1>( const uint64_t *data, size_t len );
 
 template<> std::pair< int8_t,  int8_t> calcMinMax< int8_t, 1>( const  int8_t *data, size_t len );
 template<> std::pair<int16_t, int16_t> calcMinMax<int16_t, 1>( const int16_t *data, size_t len );
 template<> std::pair<int32_t, int32_t> calcMinMax<int32_t, 1>( const int32_t *data, size_t len );
-#endif //__SSE2__
+template<> std::pair<int64_t, int64_t> calcMinMax<int64_t, 1>( const int64_t *data, size_t len );
+
+template<> std::pair<float, float> calcMinMax<float, 1>( const float *data, size_t len );
+template<> std::pair<double, double> calcMinMax<double, 1>( const double *data, size_t len );
 
 API_EXCLUDE_BEGIN
 template<typename T, bool isNumber> struct getMinMaxImpl { // fallback for unsupported types
@@ -272,16 +277,18 @@ public:
 			return boost::static_pointer_cast<const void>( m_val );
 	}
 	boost::shared_ptr<void> getRawAddress( size_t offset = 0 ) { // use the const version and cast away the const
+		touch();
 		return boost::const_pointer_cast<void>( const_cast<const ValueArray *>( this )->getRawAddress( offset ) );
 	}
 	virtual value_iterator beginGeneric() {
+		touch();
 		return value_iterator( ( uint8_t * )m_val.get(), ( uint8_t * )m_val.get(), bytesPerElem(), getValueFrom, setValueInto );
 	}
 	virtual const_value_iterator beginGeneric()const {
 		return const_value_iterator( ( uint8_t * )m_val.get(), ( uint8_t * )m_val.get(), bytesPerElem(), getValueFrom, setValueInto );
 	}
 
-	iterator begin() {return iterator( m_val.get() );}
+	iterator begin() {touch(); return iterator( m_val.get() );}
 	iterator end() {return begin() + m_len;};
 	const_iterator begin()const {return const_iterator( m_val.get() );}
 	const_iterator end()const {return begin() + m_len;}
@@ -329,7 +336,7 @@ public:
 	 * (using the given deleter) if required.
 	 * \return boost::shared_ptr\<TYPE\> handling same data as the object.
 	 */
-	operator boost::shared_ptr<TYPE>&() {return m_val;}
+	operator boost::shared_ptr<TYPE>&() {touch(); return m_val;}
 	operator const boost::shared_ptr<TYPE>&()const {return m_val;}
 
 	size_t bytesPerElem()const {return sizeof( TYPE );}
@@ -339,10 +346,16 @@ public:
 			LOG( Debug, error ) << "Skipping computation of min/max on an empty ValueArray";
 			return std::pair<util::ValueReference, util::ValueReference>();
 		} else {
+			std::pair<util::ValueReference, util::ValueReference> ret;
+			size_t generation;
 
-			const std::pair<util::Value<TYPE>, util::Value<TYPE> > result = _internal::getMinMaxImpl<TYPE, boost::is_arithmetic<TYPE>::value>()( *this );
+			if( !getCachedMinMax( ret, generation ) ) {
+				const std::pair<util::Value<TYPE>, util::Value<TYPE> > result = _internal::getMinMaxImpl<TYPE, boost::is_arithmetic<TYPE>::value>()( *this );
+				ret = std::make_pair( util::ValueReference( result.first ), util::ValueReference( result.second ) );
+				setCachedMinMax( ret, generation );
+			}
 
-			return std::make_pair( util::ValueReference( result.first ), util::ValueReference( result.second ) );
+			return ret;
 		}
 	}
 
@@ -362,11 +375,17 @@ public:
 
 		DelProxy proxy( *this );
 
-		for ( size_t i = 0; i < fullSplices; i++ )
-			ret[i].reset( new ValueArray( m_val.get() + i * size, size, proxy ) );
+		for ( size_t i = 0; i < fullSplices; i++ ) {
+			ValueArray *splice = new ValueArray( m_val.get() + i * size, size, proxy );
+			splice->shareStatsState( *this );
+			ret[i].reset( splice );
+		}
 
-		if ( lastSize )
-			ret.back().reset( new ValueArray( m_val.get() + fullSplices * size, lastSize, proxy ) );
+		if ( lastSize ) {
+			ValueArray *splice = new ValueArray( m_val.get() + fullSplices * size, lastSize, proxy );
+			splice->shareStatsState( *this );
+			ret.back().reset( splice );
+		}
 
 		return ret;
 	}
@@ -397,6 +416,56 @@ template<typename T> bool ValueArrayBase::is()const
 	return getTypeID() == ValueArray<T>::staticID;
 }
 
+/// @cond _internal
+namespace _internal
+{
+template<typename ARRAY, typename OP> bool visitNumeric( ARRAY &array, OP &op )
+{
+	switch( array.getTypeID() ) {
+#define VISIT_CASE(TYPE) case ValueArray<TYPE>::staticID: op( array.template castToValueArray<TYPE>() ); return true;
+		VISIT_CASE( int8_t ) VISIT_CASE( uint8_t ) VISIT_CASE( int16_t ) VISIT_CASE( uint16_t ) VISIT_CASE( int32_t ) VISIT_CASE( uint32_t )
+		VISIT_CASE( int64_t ) VISIT_CASE( uint64_t ) VISIT_CASE( float ) VISIT_CASE( double )
+#undef VISIT_CASE
+	default:
+		return false;
+	}
+}
+}
+/// @endcond _internal
+
+/**
+ * Run a functor on the typed ValueArray behind a ValueArrayBase.
+ * The type of the data is resolved once and op is called with the actual ValueArray\<T\>.
+ * So op can work on the typed data directly, instead of creating a ValueReference for each element.
+ * \param array the data to work on
+ * \param op a functor which will be called as op(ValueArray<T> &), it must accept all scalar number types (int8_t to uint64_t, float and double)
+ * \returns true if op was called, false if the data are not scalar numbers
+ */
+template<typename OP> bool visit( ValueArrayBase &array, OP &op )
+{
+	return _internal::visitNumeric( array, op );
+}
+/// \copydoc visit
+template<typename OP> bool visit( const ValueArrayBase &array, OP &op )
+{
+	return _internal::visitNumeric( array, op );
+}
+
+/// @cond _internal
+namespace _internal
+{
+struct NoOpVisitor {
+	template<typename T> void operator()( const ValueArray<T> &/*array*/ )const {}
+};
+/// \returns true if the data are scalar numbers (the types visit works on)
+inline bool isNumber( const ValueArrayBase &array )
+{
+	const NoOpVisitor op = {};
+	return visit( array, op );
+}
+}
+/// @endcond _internal
+
 
 }
 }
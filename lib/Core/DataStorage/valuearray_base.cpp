@@ -5,6 +5,10 @@
 #include "valuearray_base.hpp"
 #include "valuearray_converter.hpp"
 #include "common.hpp"
+#include "numeric_convert.hpp"
+#include "../CoreUtils/threadpool.hpp"
+#include <boost/thread/locks.hpp>
+#include <cmath>
 
 namespace isis
 {
@@ -25,7 +29,8 @@ scaling_pair ValueArrayBase::getScaling( const scaling_pair &scaling, short unsi
 		return scaling;
 }
 
-ValueArrayBase::ValueArrayBase( size_t length ): m_len( length ) {}
+ValueArrayBase::ValueArrayBase( size_t length ):
+	m_stats( new _internal::StatsCache( boost::shared_ptr<_internal::StatsState>( new _internal::StatsState ) ) ), m_len( length ) {}
 
 size_t ValueArrayBase::getLength() const { return m_len;}
 
@@ -61,39 +66,203 @@ const ValueArrayBase::Converter &ValueArrayBase::getConverterTo( unsigned short
 	return f2->second;
 }
 
+CompareResult::CompareResult(): compared( 0 ), different( 0 ), first( 0 ), maxAbsDiff( 0 ), sumSquares( 0 ) {}
+
+double CompareResult::rms()const
+{
+	return compared ? std::sqrt( sumSquares / compared ) : 0;
+}
+
+CompareResult &CompareResult::operator+=( const CompareResult &next )
+{
+	if( !different && next.different )
+		first = compared + next.first;
+
+	compared += next.compared;
+	different += next.different;
+	maxAbsDiff = std::max( maxAbsDiff, next.maxAbsDiff );
+	sumSquares += next.sumSquares;
+	return *this;
+}
+
 size_t ValueArrayBase::compare( size_t start, size_t end, const ValueArrayBase &dst, size_t dst_start ) const
 {
-	assert( start <= end );
-	size_t ret = 0;
-	size_t _length = end - start;
+	return compare( start, end, dst, dst_start, compare_exact ).different;
+}
 
-	if ( dst.getTypeID() != getTypeID() ) {
-		LOG( Debug, error )
-				<< "Comparing to a ValueArray of different type(" << dst.getTypeName() << ", not " << getTypeName()
-				<< "). Assuming all voxels to be different";
-		return _length;
+/// @cond _internal
+namespace _internal
+{
+// compares numbers of the same type
+struct TypedCompare {
+	const ValueArrayBase *dst;
+	size_t start, end, dst_start;
+	compareMode mode;
+	double tolerance;
+	bool stopAtFirst;
+	CompareResult *result;
+	template<typename T> void operator()( const ValueArray<T> &src )const {
+		*result = numeric_compare( &src[start], &dst->castToValueArray<T>()[dst_start], end - start, mode, tolerance, stopAtFirst );
+	}
+};
+// compares numbers of different types by converting them to double step by step
+CompareResult convertingCompare( const ValueArrayBase &src, size_t start, size_t end, const ValueArrayBase &dst, size_t dst_start, compareMode mode, double tolerance, bool stopAtFirst )
+{
+	static const size_t step = 4096;
+	std::vector<double> src_buff( step ), dst_buff( step );
+	CompareResult ret;
+
+	for( size_t i = start; i < end && !( stopAtFirst && ret.different ); i += step ) {
+		const size_t len = std::min( step, end - i );
+		src.getValues( &src_buff[0], i, len );
+		dst.getValues( &dst_buff[0], dst_start + i - start, len );
+		ret += numeric_compare( &src_buff[0], &dst_buff[0], len, mode, tolerance, stopAtFirst );
 	}
 
-	LOG_IF( end >= getLength(), Runtime, error )
-			<< "End of the range (" << end << ") is behind the end of this ValueArray (" << getLength() << ")";
-	LOG_IF( _length + dst_start >= dst.getLength(), Runtime, error )
-			<< "End of the range (" << _length + dst_start << ") is behind the end of the destination (" << dst.getLength() << ")";
-
+	return ret;
+}
+// compares any data of the same type byte by byte
+CompareResult rawCompare( const ValueArrayBase &src, size_t start, size_t end, const ValueArrayBase &dst, size_t dst_start, bool stopAtFirst )
+{
 	// lock the memory so we can mem-compare the elements (use uint8_t because some compilers do not like arith on void*)
 	const boost::shared_ptr<const uint8_t>
-	src_s = boost::static_pointer_cast<const uint8_t>( getRawAddress() ),
+	src_s = boost::static_pointer_cast<const uint8_t>( src.getRawAddress() ),
 	dst_s = boost::static_pointer_cast<const uint8_t>( dst.getRawAddress() );
-	const uint8_t *src_p = src_s.get(), *dst_p = dst_s.get();
-	const size_t el_size = bytesPerElem();
+	const uint8_t *src_p = src_s.get() + start * src.bytesPerElem(), *dst_p = dst_s.get() + dst_start * dst.bytesPerElem();
+	const size_t el_size = src.bytesPerElem();
+	CompareResult ret;
+
+	for ( ; ret.compared < end - start && !( stopAtFirst && ret.different ); ret.compared++ ) {
+		if ( memcmp( src_p + ret.compared * el_size, dst_p + ret.compared * el_size, el_size ) != 0 ) {
+			if( !ret.different++ )
+				ret.first = ret.compared;
+		}
+	}
+
+	return ret;
+}
+// compares a block of a ValueArray (see ValueArrayBase::compare)
+struct CompareBlock {
+	const ValueArrayBase *src, *dst;
+	size_t start, dst_start;
+	compareMode mode;
+	double tolerance;
+	bool stopAtFirst, sameType, numbers;
+	CompareResult *results;
+	void operator()( size_t block, size_t b_start, size_t b_end )const {
+		if( !numbers ) {
+			results[block] = rawCompare( *src, start + b_start, start + b_end, *dst, dst_start + b_start, stopAtFirst );
+		} else if( sameType ) {
+			const TypedCompare op = {dst, start + b_start, start + b_end, dst_start + b_start, mode, tolerance, stopAtFirst, &results[block]};
+			visit( *src, op );
+		} else {
+			results[block] = convertingCompare( *src, start + b_start, start + b_end, *dst, dst_start + b_start, mode, tolerance, stopAtFirst );
+		}
+	}
+};
+}
+/// @endcond _internal
+
+CompareResult ValueArrayBase::compare( size_t start, size_t end, const ValueArrayBase &dst, size_t dst_start, compareMode mode, double tolerance, bool stopAtFirst ) const
+{
+	assert( start <= end );
+	const size_t length = end - start;
+	CompareResult ret;
+
+	if( end > getLength() || dst_start + length > dst.getLength() ) {
+		LOG( Debug, error )
+				<< "The range [" << start << "," << end << ") or [" << dst_start << "," << dst_start + length << ") is behind the end of the data ("
+				<< getLength() << "/" << dst.getLength() << "). Assuming all voxels to be different";
+		ret.compared = ret.different = length;
+		return ret;
+	}
+
+	const bool sameType = dst.getTypeID() == getTypeID();
+	const bool numbers = _internal::isNumber( *this ) && _internal::isNumber( dst );
+
+	if( length == 0 )
+		return ret;
+
+	if( !sameType && !numbers ) {
+		LOG( Debug, error )
+				<< "Cannot compare " << getTypeName() << " to " << dst.getTypeName() << ". Assuming all voxels to be different";
+		ret.compared = ret.different = length;
+		return ret;
+	}
 
-	for ( size_t i = start; i < end; i++ ) {
-		if ( memcmp( src_p + ( i * el_size ), dst_p + ( i * el_size ), el_size ) != 0 )
-			ret++;
+	LOG_IF( !numbers && mode != compare_exact, Debug, warning ) << getTypeName() << " can only be compared exactly, ignoring the tolerance";
+
+	// blocks must be big enough to outweigh the cost of handing them to another thread
+	static const size_t min_block = 64 * 1024;
+	util::ThreadPool &pool = util::ThreadPool::global();
+	std::vector<CompareResult> results( pool.getBlocks( length, min_block ) );
+	const _internal::CompareBlock op = {this, &dst, start, dst_start, mode, tolerance, stopAtFirst, sameType, numbers, &results[0]};
+	pool.forEachBlock( length, min_block, op );
+
+	for( std::vector<CompareResult>::const_iterator i = results.begin(); i != results.end() && !( stopAtFirst && ret.different ); ++i )
+		ret += *i;
+
+	return ret;
+}
+
+/// @cond _internal
+namespace _internal
+{
+template<typename T> struct ValuesGetter {
+	T *dst;
+	size_t start, count;
+	double scale, offset;
+	template<typename SRC> void operator()( const ValueArray<SRC> &src )const {
+		numeric_convert( &src[start], dst, count, scale, offset );
+	}
+};
+template<typename T> struct ValuesSetter {
+	const T *src;
+	size_t start, count;
+	template<typename DST> void operator()( ValueArray<DST> &dst )const {
+		numeric_convert( src, &dst[start], count, 1, 0 ); // operator[] invalidates the cached statistics
+	}
+};
+}
+/// @endcond _internal
+
+template<typename T> bool ValueArrayBase::getValues( T *dst, size_t start, size_t count )const
+{
+	return getValues( dst, start, count, 1, 0 );
+}
+template<typename T> bool ValueArrayBase::getValues( T *dst, size_t start, size_t count, double scale, double offset )const
+{
+	if( start + count > getLength() ) {
+		LOG( Debug, error ) << "The range [" << start << "," << start + count << ") is behind the end of this ValueArray (" << getLength() << ")";
+		return false;
+	}
+
+	const _internal::ValuesGetter<T> op = {dst, start, count, scale, offset};
+	const bool ret = count == 0 || visit( *this, op );
+	LOG_IF( !ret, Debug, error ) << "Cannot get the values of a " << getTypeName() << " as " << util::Value<T>::staticName();
+	return ret;
+}
+template<typename T> bool ValueArrayBase::setValues( const T *src, size_t start, size_t count )
+{
+	if( start + count > getLength() ) {
+		LOG( Debug, error ) << "The range [" << start << "," << start + count << ") is behind the end of this ValueArray (" << getLength() << ")";
+		return false;
 	}
 
+	const _internal::ValuesSetter<T> op = {src, start, count};
+	const bool ret = count == 0 || visit( *this, op );
+	LOG_IF( !ret, Debug, error ) << "Cannot set the values of a " << getTypeName() << " from " << util::Value<T>::staticName();
 	return ret;
 }
 
+#define INSTANTIATE_VALUES(TYPE)                                                                                              \
+	template bool ValueArrayBase::getValues<TYPE>( TYPE *dst, size_t start, size_t count )const;                              \
+	template bool ValueArrayBase::getValues<TYPE>( TYPE *dst, size_t start, size_t count, double scale, double offset )const; \
+	template bool ValueArrayBase::setValues<TYPE>( const TYPE *src, size_t start, size_t count );
+INSTANTIATE_VALUES( int8_t ) INSTANTIATE_VALUES( uint8_t ) INSTANTIATE_VALUES( int16_t ) INSTANTIATE_VALUES( uint16_t )
+INSTANTIATE_VALUES( int32_t ) INSTANTIATE_VALUES( uint32_t ) INSTANTIATE_VALUES( int64_t ) INSTANTIATE_VALUES( uint64_t )
+INSTANTIATE_VALUES( float ) INSTANTIATE_VALUES( double )
+#undef INSTANTIATE_VALUES
 
 ValueArrayBase::Reference ValueArrayBase::copyByID( unsigned short ID, scaling_pair scaling ) const
 {
@@ -104,6 +273,7 @@ ValueArrayBase::Reference ValueArrayBase::copyByID( unsigned short ID, scaling_p
 	if( conv ) {
 		boost::scoped_ptr<ValueArrayBase> ret;
 		conv->generate( *this, ret, getScaling( scaling, ID ) );
+		ret->invalidateStats(); // the new data are complete, and nobody else got writing access to them
 		return *ret;
 	} else {
 		LOG( Runtime, error )
@@ -207,6 +377,45 @@ scaling_pair ValueArrayBase::getScalingTo( unsigned short typeID, const std::pai
 		return scaling_pair();
 	}
 }
+void ValueArrayBase::beginWriting()
+{
+	boost::lock_guard<boost::mutex> lock( m_stats->state->mutex );
+	m_stats->state->writing = true;
+	m_stats->state->generation++;
+}
+void ValueArrayBase::invalidateStats()
+{
+	boost::lock_guard<boost::mutex> lock( m_stats->state->mutex );
+	m_stats->state->writing = false;
+	m_stats->state->generation++;
+}
+bool ValueArrayBase::getCachedMinMax( std::pair<util::ValueReference, util::ValueReference> &minmax, size_t &generation )const
+{
+	boost::lock_guard<boost::mutex> lock( m_stats->state->mutex );
+
+	if( !m_stats->state->writing && m_stats->has_minmax && m_stats->minmax_generation == m_stats->state->generation ) {
+		minmax = m_stats->minmax;
+		return true;
+	} else {
+		generation = m_stats->state->generation;
+		return false;
+	}
+}
+void ValueArrayBase::setCachedMinMax( const std::pair<util::ValueReference, util::ValueReference> &minmax, size_t generation )const
+{
+	boost::lock_guard<boost::mutex> lock( m_stats->state->mutex );
+
+	if( !m_stats->state->writing && m_stats->state->generation == generation ) { // if the data were written meanwhile, the result is useless
+		m_stats->minmax = minmax;
+		m_stats->minmax_generation = generation;
+		m_stats->has_minmax = true;
+	}
+}
+void ValueArrayBase::shareStatsState( const ValueArrayBase &master )
+{
+	m_stats.reset( new _internal::StatsCache( master.m_stats->state ) );
+}
+
 size_t ValueArrayBase::useCount() const
 {
 	return getRawAddress().use_count();
@@ -24,6 +24,8 @@
 #include "common.hpp"
 #include <boost/mpl/if.hpp>
 #include <boost/utility/enable_if.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
 
 namespace isis
 {
@@ -119,14 +121,59 @@ public:
 template<> GenericValueIterator<true>::reference GenericValueIterator<true>::operator*() const;
 template<> GenericValueIterator<false>::reference GenericValueIterator<false>::operator*() const;
 
+/**
+ * State of the cached statistics of some data.
+ * It is shared by a ValueArray, its copies and its splices.
+ * So writing into any of them invalidates the cached statistics of all of them.
+ */
+struct StatsState {
+	StatsState(): generation( 0 ), writing( false ) {}
+	boost::mutex mutex; // guards generation and the StatsCache objects using this state
+	size_t generation; // incremented each time the data are changed (cached statistics of older generations are invalid)
+	boost::atomic<bool> writing; // writing access was given and might still be used, so nothing is cached until invalidateStats is called
+};
+/// The cached statistics shared by a ValueArray and its copies (splices have their own).
+struct StatsCache {
+	StatsCache( const boost::shared_ptr<StatsState> &_state ): state( _state ), minmax_generation( 0 ), has_minmax( false ) {}
+	const boost::shared_ptr<StatsState> state;
+	size_t minmax_generation; // the generation of state minmax was computed in
+	bool has_minmax;
+	std::pair<util::ValueReference, util::ValueReference> minmax;
+};
+
 } //namespace _internal
 /// @endcond _internal
 
+/// How two values are checked for being different when comparing data (see ValueArrayBase::compare)
+enum compareMode {
+	compare_exact = 0, ///< values are different if they are not equal
+	compare_absolute,  ///< values are different if |a-b| \> tolerance
+	compare_relative   ///< values are different if |a-b| \> tolerance*max(|a|,|b|)
+};
+
+/**
+ * The result of a comparison of data (see ValueArrayBase::compare and Image::compare).
+ * NaN is regarded equal to NaN, but different to any number. Pairs containing NaN are not part of the statistics.
+ */
+struct CompareResult {
+	size_t compared;   ///< the amount of values which were compared
+	size_t different;  ///< the amount of values which were found different
+	size_t first;      ///< the index of the first different value (relative to the start of the comparison), only valid if different\>0
+	double maxAbsDiff; ///< the biggest absolute difference found
+	double sumSquares; ///< the sum of all squared differences
+	CompareResult();
+	/// \returns the root mean square of the differences
+	double rms()const;
+	/// Add the result of the comparison of the values following the ones of this result.
+	CompareResult &operator+=( const CompareResult &next );
+};
+
 class ValueArrayBase : public util::_internal::GenericValue
 {
 	friend class util::_internal::GenericReference<ValueArrayBase>;
 	static const _internal::ValueArrayConverterMap &converters();
 	scaling_pair getScaling( const scaling_pair &scale, unsigned short ID )const;
+	boost::shared_ptr<_internal::StatsCache> m_stats;
 protected:
 	size_t m_len;
 	ValueArrayBase( size_t len = 0 );
@@ -134,6 +181,25 @@ protected:
 	/// Create a ValueArray of the same type pointing at the same address.
 	virtual ValueArrayBase *clone()const = 0;
 
+	/// Has to be called by everything giving writing access to the data (it stops the caching of statistics until invalidateStats is called).
+	void touch() {
+		if( !m_stats->state->writing.load( boost::memory_order_acquire ) ) // only a load if writing access was given already
+			beginWriting();
+	}
+	/// Drop the cached statistics and don't cache any until invalidateStats is called.
+	void beginWriting();
+	/**
+	 * Get the cached min/max.
+	 * \param minmax the cached min/max (if there is one)
+	 * \param generation set to the current generation of the cache if there is no valid min/max (to be given to setCachedMinMax)
+	 * \returns true if there is a valid cached min/max, false otherwise
+	 */
+	bool getCachedMinMax( std::pair<util::ValueReference, util::ValueReference> &minmax, size_t &generation )const;
+	/// Store the min/max in the cache if the data were not written to since generation was read by getCachedMinMax.
+	void setCachedMinMax( const std::pair<util::ValueReference, util::ValueReference> &minmax, size_t generation )const;
+	/// Use the same cache state as master (used for splices, so writing into them invalidates the master's cache and vice versa).
+	void shareStatsState( const ValueArrayBase &master );
+
 public:
 	typedef _internal::GenericValueIterator<false> value_iterator;
 	typedef _internal::GenericValueIterator<true> const_value_iterator;
@@ -351,23 +417,84 @@ public:
 	 * if(minmax1.first->gt(minmax2.second) && minmax1.second->lt(minmax2.second)
 	 *  std::cout << minmax1 << " is a subset of " minmax2 << std::endl;
 	 * \endcode
+	 * The result is cached as long as no writing access to the data is given (see invalidateStats).
 	 * \returns a pair of ValueReferences referring to the found minimum/maximum of the data
 	 */
 	virtual std::pair<util::ValueReference, util::ValueReference> getMinMax()const = 0;
 
+	/**
+	 * Tell the ValueArray that writing into its data is finished.
+	 * Writing access given via operator[], the iterators, copyFromMem or getRawAddress of a non-const ValueArray drops the cached statistics (e.g. min/max).
+	 * As the references, pointers and iterators given out can be used for writing at any time later, no statistics are cached after that.
+	 * They are computed on each request instead, until this is called to say that none of them is used for writing anymore.
+	 * It also affects all copies and splices of this ValueArray.
+	 */
+	void invalidateStats();
+
 	/**
 	 * Compare the data of two ValueArray.
 	 * Counts how many elements in this and the given ValueArray are different within the given range.
-	 * If the type of this is not equal to the type of the given ValueArray the whole length is assumed to be different.
+	 * This is the exact comparison of compare( start, end, dst, dst_start, compare_exact ), so scalar numbers of different types are compared by their value.
+	 * Other types which are not equal to the type of the given ValueArray are assumed to be different over the whole length.
 	 * If the given range does not fit into this or the given ValueArray an error is send to the runtime log and the function will probably crash.
 	 * \param start the first element in this, which schould be compared to the first element in the given TyprPtr
 	 * \param end the first element in this, which should _not_ be compared anymore to the given TyprPtr
 	 * \param dst the given ValueArray this should be compared to
 	 * \param dst_start the first element in the given TyprPtr, which schould be compared to the first element in this
-	 * \returns the amount of elements which actually differ in both ValueArray or the whole length of the range when the types are not equal.
+	 * \returns the amount of elements which actually differ in both ValueArray or the whole length of the range when they cannot be compared.
 	 */
 	size_t compare( size_t start, size_t end, const ValueArrayBase &dst, size_t dst_start )const;
 
+	/**
+	 * Compare the data of two ValueArray using the given tolerance.
+	 * Big ranges are compared in parallel blocks and the values are compared using the best instruction set the cpu supports.
+	 * If both ValueArray are scalar numbers of different types, the values are converted to double for comparison.
+	 * Other types (e.g. color) can only be compared exactly, and only to their own type.
+	 * \param start the first element in this, which schould be compared to the first element in the given ValueArray
+	 * \param end the first element in this, which should _not_ be compared anymore
+	 * \param dst the given ValueArray this should be compared to
+	 * \param dst_start the first element in the given ValueArray, which schould be compared to the first element in this
+	 * \param mode how values are checked for being different
+	 * \param tolerance the allowed absolute or relative difference (ignored for compare_exact)
+	 * \param stopAtFirst stop comparing after the first difference was found.
+	 * Then only CompareResult::first is reliable, the other members only cover the values compared up to that point.
+	 * \returns the result of the comparison, if the data cannot be compared all values in the range are regarded different
+	 */
+	CompareResult compare( size_t start, size_t end, const ValueArrayBase &dst, size_t dst_start, compareMode mode, double tolerance = 0, bool stopAtFirst = false )const;
+
+	/**
+	 * Copy a range of elements into a buffer of scalar numbers.
+	 * The elements are converted to T without scaling (rounded and saturated if T is an integer), or just copied if they are of type T.
+	 * The type of the data is resolved once for the whole range, so this is the way to read data of unknown type (instead of going through beginGeneric() for each element).
+	 * \param dst the buffer to write into (must have room for count elements), T can be any scalar number type
+	 * \param start the first element to be copied
+	 * \param count the amount of elements to be copied
+	 * \returns false if the range is not inside of this or the data are not scalar numbers (nothing is copied then), true otherwise
+	 */
+	template<typename T> bool getValues( T *dst, size_t start, size_t count )const;
+
+	/**
+	 * Copy a range of elements into a buffer of scalar numbers using the given scaling.
+	 * The same as getValues(T*,size_t,size_t), but the values are converted as dst[i] = round( value * scale + offset ).
+	 * \param dst the buffer to write into (must have room for count elements), T can be any scalar number type
+	 * \param start the first element to be copied
+	 * \param count the amount of elements to be copied
+	 * \param scale the scaling factor
+	 * \param offset the offset
+	 * \returns false if the range is not inside of this or the data are not scalar numbers (nothing is copied then), true otherwise
+	 */
+	template<typename T> bool getValues( T *dst, size_t start, size_t count, double scale, double offset )const;
+
+	/**
+	 * Copy scalar numbers from a buffer into a range of elements.
+	 * This is the reverse of getValues: the values are converted to the type of this without scaling.
+	 * \param src the buffer to read from (must hold count values), T can be any scalar number type
+	 * \param start the first element to be overwritten
+	 * \param count the amount of elements to be overwritten
+	 * \returns false if the range is not inside of this or the data are not scalar numbers (nothing is copied then), true otherwise
+	 */
+	template<typename T> bool setValues( const T *src, size_t start, size_t count );
+
 	virtual void endianSwap() = 0;
 };
 
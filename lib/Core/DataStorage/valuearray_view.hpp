@@ -0,0 +1,168 @@
+#ifndef VALUEARRAY_VIEW_HPP
+#define VALUEARRAY_VIEW_HPP
+
+#include "valuearray.hpp"
+#include <vector>
+#include <algorithm>
+#include <boost/mpl/bool.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+namespace isis
+{
+namespace data
+{
+
+/**
+ * A read-only view of a ValueArray as the type T, which converts the elements on demand.
+ * Unlike ValueArrayBase::as or ValueArrayBase::copyByID, this does not allocate a converted copy of all elements.
+ * The elements are converted into a small buffer (a tile) when they are accessed, so data of any numeric type can be read as T with bounded memory.
+ * If the data already are of type T and no scaling is needed, the view reads the original data directly.
+ *
+ * Only scalar numbers can be converted tile by tile. Other types (e.g. color or complex) are converted as a whole when the view is created.
+ *
+ * The view keeps the original data alive but does not copy them.
+ * Changes to the data are visible in the view once the affected tile is converted again (see reset()).
+ * A view is not thread safe, because every access can overwrite its buffer. Copies of a view have their own buffer, so use one copy per thread.
+ */
+template<typename T> class ValueArrayView
+{
+	typedef boost::mpl::bool_ < boost::is_arithmetic<T>::value && !boost::is_same<T, bool>::value > is_number;
+
+	ValueArrayBase::Reference m_src; // the source if it is converted tile by tile (empty otherwise)
+	ValueArray<T> m_direct; // the source or its converted copy if it is read directly
+	size_t m_length, m_tileSize;
+	double m_scale, m_offset;
+	mutable std::vector<T> m_tile;
+	mutable size_t m_tileStart, m_tileLength;
+
+	static bool canConvertTiles( const ValueArrayBase &src, boost::mpl::bool_<true> ) {
+		return _internal::isNumber( src );
+	}
+	static bool canConvertTiles( const ValueArrayBase &/*src*/, boost::mpl::bool_<false> ) {return false;}
+
+	bool fetch( T *dst, size_t start, size_t count, boost::mpl::bool_<true> )const {
+		return m_src->getValues( dst, start, count, m_scale, m_offset );
+	}
+	bool fetch( T */*dst*/, size_t /*start*/, size_t /*count*/, boost::mpl::bool_<false> )const {return false;} // never used, m_src is only set for numbers
+
+	void convertTile( size_t start )const {
+		m_tileStart = start;
+		m_tileLength = std::min( m_tileSize, m_length - start );
+		fetch( &m_tile[0], m_tileStart, m_tileLength, is_number() );
+	}
+public:
+	static const size_t defaultTileSize = 4096;
+
+	/**
+	 * Create a view of the given data as T.
+	 * \param src the data to be viewed (the view keeps a cheap copy of it)
+	 * \param scaling the scaling to be used for the conversion (computed from the min/max of src if not given, like in ValueArrayBase::as)
+	 * \param tileSize the amount of elements converted at once
+	 */
+	ValueArrayView( const ValueArrayBase &src, scaling_pair scaling = scaling_pair(), size_t tileSize = defaultTileSize ):
+		m_direct( static_cast<T *>( 0 ), 0, typename ValueArray<T>::NonDeleter() ), m_length( src.getLength() ), m_tileSize( std::max<size_t>( tileSize, 1 ) ), m_scale( 1 ), m_offset( 0 ), m_tileStart( 0 ), m_tileLength( 0 ) {
+		if( scaling.first.isEmpty() || scaling.second.isEmpty() )
+			scaling = src.getScalingTo( ValueArray<T>::staticID );
+
+		if( scaling.first.isEmpty() || scaling.second.isEmpty() ) { // if we don't have a scaling by now conversion wont be possible
+			LOG( Runtime, error ) << "Cannot view a " << src.getTypeName() << " as " << ValueArray<T>::staticName() << ", the view will be empty";
+			m_length = 0;
+			return;
+		}
+
+		m_scale = scaling.first->as<double>();
+		m_offset = scaling.second->as<double>();
+
+		if( src.is<T>() && m_scale == 1 && m_offset == 0 ) {
+			m_direct = src.castToValueArray<T>(); // cheap copy
+		} else if( canConvertTiles( src, is_number() ) ) {
+			m_src = src; // cheap copy
+			m_tile.resize( m_tileSize );
+		} else {
+			LOG( Debug, info ) << "Converting the whole " << src.getTypeName() << " to " << ValueArray<T>::staticName() << ", because it cannot be converted partially";
+			const ValueArrayBase::Reference converted = src.copyByID( ValueArray<T>::staticID, scaling );
+
+			if( converted.isEmpty() )
+				m_length = 0;
+			else
+				m_direct = converted->template castToValueArray<T>();
+		}
+	}
+
+	/// \returns the amount of elements in the view
+	size_t getLength()const {return m_length;}
+	/// \returns the maximum amount of elements converted at once
+	size_t getTileSize()const {return m_tileSize;}
+	/// \returns true if the elements are converted on access, false if the view reads them directly
+	bool isConverting()const {return !m_src.isEmpty();}
+
+	/// \returns the (converted) element at the given index
+	T operator[]( size_t idx )const {
+		if( m_src.isEmpty() )
+			return m_direct[idx];
+
+		if( idx - m_tileStart >= m_tileLength ) // not in the current tile (wraps around if idx<m_tileStart)
+			convertTile( idx - idx % m_tileSize );
+
+		return m_tile[idx - m_tileStart];
+	}
+
+	/**
+	 * Get a pointer to a block of (converted) elements.
+	 * If the view converts, the pointer points into the buffer of the view and is only valid until the next access to the view.
+	 * \param start the first element of the block
+	 * \param count the length of the block (must not be bigger than getTileSize())
+	 * \returns a pointer to the elements [start,start+count)
+	 */
+	const T *getBlock( size_t start, size_t count )const {
+		assert( start + count <= m_length && count <= m_tileSize );
+
+		if( m_src.isEmpty() )
+			return &m_direct[start];
+
+		if( start < m_tileStart || start + count > m_tileStart + m_tileLength )
+			convertTile( start );
+
+		return &m_tile[start - m_tileStart];
+	}
+
+	/**
+	 * Convert a range of elements into the given memory, bypassing the buffer of the view.
+	 * \param dst the memory to write into (must have room for count elements)
+	 * \param start the first element to be copied
+	 * \param count the amount of elements to be copied
+	 * \returns false if the range is not inside of the view, true otherwise
+	 */
+	bool copyToMem( T *dst, size_t start, size_t count )const {
+		if( start + count > m_length ) {
+			LOG( Debug, error ) << "The range [" << start << "," << start + count << ") is behind the end of this view (" << m_length << ")";
+			return false;
+		}
+
+		if( m_src.isEmpty() ) {
+			std::copy( &m_direct[0] + start, &m_direct[0] + start + count, dst );
+			return true;
+		} else
+			return fetch( dst, start, count, is_number() );
+	}
+
+	/**
+	 * Run an operation on all elements block by block.
+	 * op( block, start, count ) is called for consecutive blocks of at most getTileSize() elements, where block points to the elements [start,start+count).
+	 */
+	template<typename OP> void forEachBlock( OP &op )const {
+		for( size_t start = 0; start < m_length; start += m_tileSize ) {
+			const size_t count = std::min( m_tileSize, m_length - start );
+			op( getBlock( start, count ), start, count );
+		}
+	}
+
+	/// Drop the converted elements, so that changes to the source become visible.
+	void reset() {m_tileLength = 0;}
+};
+
+}
+}
+
+#endif // VALUEARRAY_VIEW_HPP
@@ -9,6 +9,18 @@
 #define API_EXCLUDE_END   _Pragma("GCC visibility pop")
 #endif
 
+// runtime dispatching to avx2/avx512 needs the target-attribute and __builtin_cpu_supports of gcc (or clang)
+// (see data::getSimdLevel)
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define ISIS_SIMD_DISPATCH 1
+#define ISIS_TARGET_DEFAULT
+#define ISIS_TARGET_AVX2 __attribute__((target("avx2")))
+#define ISIS_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl")))
+#else
+#define ISIS_SIMD_DISPATCH 0
+#define ISIS_TARGET_DEFAULT
+#endif
+
 #ifdef _MSC_VER
 typedef boost::int8_t   int8_t;
 typedef boost::int16_t  int16_t;
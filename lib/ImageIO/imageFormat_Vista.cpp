@@ -31,6 +31,8 @@
 #include <viaio/option.h>
 #include <boost/mpl/if.hpp>
 #include <boost/type_traits/is_unsigned.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
 
 namespace isis
 {
@@ -220,6 +222,10 @@ int ImageFormat_Vista::load( std::list<data::Chunk> &chunks, const std::string &
 							 boost::shared_ptr<util::ProgressFeedback> progress
 						   ) throw ( std::runtime_error & )
 {
+	// neither libviaio nor the faked sequenceNumber (see addChunk) are thread safe, so only one file is loaded at a time
+	static boost::mutex load_mutex;
+	boost::lock_guard<boost::mutex> lock( load_mutex );
+
 	// open input file
 	FILE *ip;
 	util::istring myDialect = dialect;
@@ -613,14 +619,15 @@ int ImageFormat_Vista::load( std::list<data::Chunk> &chunks, const std::string &
 			// splice VistaChunk
 			std::list<data::Chunk> splices = sliceRef.splice( data::sliceDim );
 			/******************** SET acquisitionTime ********************/
+			static const util::PropertyMap::PropPath acquisitionNumberProp( "acquisitionNumber" ), acquisitionTimeProp( "acquisitionTime" );
 			size_t timestep = 0;
 			BOOST_FOREACH( data::Chunk & spliceRef, splices ) {
 				uint32_t acqusitionNumber = ( nloaded - 1 ) + vImageVector.size() * timestep;
-				spliceRef.setPropertyAs<uint32_t>( "acquisitionNumber", acqusitionNumber );
+				spliceRef.setPropertyAs<uint32_t>( acquisitionNumberProp, acqusitionNumber );
 
-				if ( repetitionTime && sliceRef.hasProperty( "acquisitionTime" ) ) {
-					float acquisitionTimeSplice = sliceRef.getPropertyAs<float>( "acquisitionTime" ) + ( repetitionTime * timestep );
-					spliceRef.setPropertyAs<float>( "acquisitionTime", acquisitionTimeSplice );
+				if ( repetitionTime && sliceRef.hasProperty( acquisitionTimeProp ) ) {
+					float acquisitionTimeSplice = sliceRef.getPropertyAs<float>( acquisitionTimeProp ) + ( repetitionTime * timestep );
+					spliceRef.setPropertyAs<float>( acquisitionTimeProp, acquisitionTimeSplice );
 				}
 
 				// add history information
@@ -1005,8 +1012,11 @@ template <typename T> bool ImageFormat_Vista::copyImageToVista( const data::Imag
 	for ( size_t z = 0; z < isize[2]; z += csize[2] ) {
 		for ( size_t y = 0; y < isize[1]; y += csize[1] ) {
 			for ( size_t x = 0; x < isize[0]; x += csize[0] ) {
-				data::Chunk ch = image.getChunkAs<T>( scale, x, y, z, 0 );
-				ch.getValueArray<T>().copyToMem( &VPixel( vimage, z, y, x, T ), csize.product() );
+				// convert straight into the VImage, no need for a converted copy of the chunk
+				const data::Chunk ch = image.getChunk( x, y, z, 0, false );
+
+				if( !ch.getValueArrayBase().copyToMem( &VPixel( vimage, z, y, x, T ), csize.product(), scale ) )
+					return false;
 			}
 		}
 	}
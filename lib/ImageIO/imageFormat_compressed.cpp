@@ -12,12 +12,15 @@
 #include <boost/iostreams/filter/gzip.hpp>
 #include <boost/iostreams/filter/bzip2.hpp>
 #include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <boost/filesystem/fstream.hpp>
 #include "DataStorage/fileptr.hpp"
 #include <boost/iostreams/categories.hpp>  // tags
 
+#include "imageFormat_compressed_bgzf.hpp"
+
 #ifdef HAVE_LZMA
 #include "imageFormat_compressed_lzma.hpp"
 #endif //HAVE_LZMA
@@ -117,6 +120,65 @@ private:
 
 		return red;
 	}
+	/**
+	 * Read the whole (decompressed) stream into memory.
+	 * \param size the expected size of the data, only used as the initial size of the memory (it grows if there is more)
+	 * \param filename the name of the compressed file (for error messages)
+	 */
+	static data::ValueArray<uint8_t> readAll( boost::iostreams::filtering_istream &in, size_t size, const std::string &filename ) {
+		size = std::max<size_t>( size, 0x100000 );
+		char *buff = static_cast<char *>( malloc( size ) );
+		size_t red = 0;
+
+		while( buff ) {
+			in.read( buff + red, size - red );
+			red += in.gcount();
+
+			if( in.eof() )
+				break;
+
+			if( in.fail() ) { // corrupt or truncated data don't set eof
+				free( buff );
+				throwGenericError( "Failed to decompress \"" + filename + "\" after " + boost::lexical_cast<std::string>( red ) + " bytes" );
+			}
+
+			size *= 2;
+			char *const grown = static_cast<char *>( realloc( buff, size ) );
+
+			if( !grown )
+				free( buff );
+
+			buff = grown;
+		}
+
+		if( !buff )
+			throwGenericError( "Failed to allocate " + boost::lexical_cast<std::string>( size ) + " bytes for the decompressed data" );
+
+		if( red < size ) { // give back what wasn't needed (realloc can only fail to shrink by keeping the old buffer)
+			char *const shrunk = static_cast<char *>( realloc( buff, std::max<size_t>( red, 1 ) ) );
+
+			if( shrunk )
+				buff = shrunk;
+		}
+
+		return data::ValueArray<uint8_t>( reinterpret_cast<uint8_t *>( buff ), red ); // uses free() to release buff
+	}
+	/**
+	 * Guess the size of the uncompressed data of a gzip file from the size stored at its end.
+	 * That's the size of the last member only (modulo 2^32), so it's wrong for files with more than one member (e.g. BGZF) and for big files.
+	 * \returns the stored size if it's plausible, four times the size of the file otherwise
+	 */
+	static size_t gzipSize( const std::string &filename ) {
+		const size_t packed = boost::filesystem::file_size( filename );
+		std::ifstream input( filename.c_str(), std::ios_base::binary );
+		uint8_t isize[4] = {0, 0, 0, 0};
+
+		if( input.seekg( -4, std::ios_base::end ) )
+			input.read( reinterpret_cast<char *>( isize ), 4 );
+
+		const size_t stored = isize[0] | isize[1] << 8 | isize[2] << 16 | static_cast<size_t>( isize[3] ) << 24;
+		return stored > packed ? stored : packed * 4;
+	}
 protected:
 	util::istring suffixes( io_modes modes = both )const {
 #ifdef HAVE_LZMA
@@ -181,16 +243,25 @@ public:
 			}
 		}
 
-		// set up progress bar if its enabled but don't fiddle with it if its set up already
-		if( progress && progress->getMax() == 0 ) {
-			progress->show( boost::filesystem::file_size( filename ) / _internal::progress_filter::blocksize, std::string( "decompressing " ) + filename );
-			in.push( _internal::progress_filter( *progress ) );
-		}
+		// gzip files written by this plugin (BGZF) are decompressed in parallel, so the stream only has to read the result
+		data::ValueArray<uint8_t> unpacked( static_cast<uint8_t *>( 0 ), 0, data::ValueArray<uint8_t>::NonDeleter() );
+		std::ifstream input;
+
+		if( ( suffix == ".tgz" || suffix == ".gz" ) && _internal::bgzfDecompress( data::FilePtr( filename ), unpacked ) ) {
+			in.reset(); // drop the gzip_decompressor
+			in.push( boost::iostreams::array_source( reinterpret_cast<const char *>( &unpacked[0] ), unpacked.getLength() ) );
+		} else {
+			// set up progress bar if its enabled but don't fiddle with it if its set up already
+			if( progress && progress->getMax() == 0 ) {
+				progress->show( boost::filesystem::file_size( filename ) / _internal::progress_filter::blocksize, std::string( "decompressing " ) + filename );
+				in.push( _internal::progress_filter( *progress ) );
+			}
 
-		// and on the top the source file
-		std::ifstream input( filename.c_str(), std::ios_base::binary );
-		input.exceptions( std::ios::badbit );
-		in.push( input );
+			// and on the top the source file
+			input.open( filename.c_str(), std::ios_base::binary );
+			input.exceptions( std::ios::badbit );
+			in.push( input );
+		}
 
 		if( isTar ) { // if it is tar we use out own tar "parser"
 			size_t size, next_header_in;
@@ -217,36 +288,22 @@ public:
 
 				if( tar_header.typeflag == '\0' || tar_header.typeflag == '0' ) { //only do regulars files
 
-					data::IOFactory::FileFormatList formats = data::IOFactory::getFileFormatList( org_file.string(), dialect ); // and get the reading pluging for that
+					data::IOFactory::FileFormatList formats = data::IOFactory::getFileFormatList( org_file.string(), "", dialect ); // and get the reading pluging for that
 
 					if( formats.empty() ) {
 						LOG( Runtime, notice ) << "Skipping " << org_file << " from " << filename << " because no plugin was found to read it"; // skip if we found none
 					} else {
 						LOG( Debug, info ) << "Got " << org_file << " from " << filename << " there are " << formats.size() << " plugins which should be able to read it";
 
-						const std::pair<std::string, std::string> base = formats.front()->makeBasename( org_file.string() );//ask any of the plugins for the suffix
-						util::TmpFile tmpfile( "", base.second );//create a temporary file with this suffix
-
-						data::FilePtr mfile( tmpfile, size, true );
-
-						if( !mfile.good() ) {
-							throwSystemError( errno, std::string( "Failed to open temporary " ) + tmpfile.native() );
-						}
-
-						size_t red = boost::iostreams::read( in, ( char * )&mfile[0], size ); // read data from the stream into the mapped memory
-						next_header_in -= red;
-						mfile.release(); //close and unmap the temporary file/mapped memory
-
-						if( red != size ) { // read the data from the stream
-							LOG( Runtime, warning ) << "Could not read all " << size << " bytes for " << tmpfile.native();
-						}
+						data::ValueArray<uint8_t> buff( size );
+						next_header_in -= tar_readstream( in, &buff[0], size, org_file.string() ); // read data from the stream into memory
 
-						// read the temporary file
+						// and hand it to the plugin
 						std::list<data::Chunk>::iterator ch = chunks.end();
 						--ch;
-						ret += data::IOFactory::load( chunks, tmpfile.string(), dialect.c_str() );
+						ret += data::IOFactory::load( chunks, buff, org_file.string(), "", dialect );
 
-						for( ; ch != chunks.end(); ++ch ) { // set the source property of the red chunks to something more usefull
+						for( ++ch; ch != chunks.end(); ++ch ) { // set the source property of the red chunks to something more usefull
 							ch->setPropertyAs( "source", ( boost::filesystem::path( filename ) / org_file ).native() );
 						}
 					}
@@ -264,14 +321,11 @@ public:
 				throwGenericError( "Cannot determine the uncompressed suffix of \"" + filename + "\" because no io-plugin was found for it" );
 			}
 
-			// set up the input stream
-			util::TmpFile tmpFile( "", formats.front()->makeBasename( proxyBase.first ).second );
-			boost::filesystem::ofstream output( tmpFile, std::ios_base::binary );
-			output.exceptions( std::ios::badbit );
-
-			boost::iostreams::copy( in, output );
-
-			ret = data::IOFactory::load( chunks, tmpFile.native(), dialect );
+			// decompress into memory and hand that to the plugin
+			const data::ValueArray<uint8_t> buff = unpacked.getLength() ?
+												   unpacked :
+												   readAll( in, suffix == ".gz" ? gzipSize( filename ) : boost::filesystem::file_size( filename ) * 4, filename );
+			ret = data::IOFactory::load( chunks, buff, proxyBase.first, "", dialect );
 
 			if( ret ) { //re-set source of all new chunks
 				prev++;
@@ -299,11 +353,22 @@ public:
 
 		if( !data::IOFactory::write( image, tmpFile.native(), dialect ) ) {throwGenericError( tmpFile.native() + " failed to write" );}
 
+		std::ofstream output( filename.c_str(), std::ios_base::binary );
+		output.exceptions( std::ios::badbit );
+
+		if( suffix == ".gz" ) { // gzip is compressed in parallel
+			const data::FilePtr mfile( tmpFile );
+
+			if( progress )
+				progress->show( mfile.getLength() / _internal::progress_filter::blocksize, std::string( "compressing " ) + filename );
+
+			_internal::bgzfCompress( mfile.getLength() ? &mfile[0] : NULL, mfile.getLength(), output, progress );
+			return;
+		}
+
 		// set up the compression stream
 		boost::filesystem::ifstream input( tmpFile, std::ios_base::binary );
-		std::ofstream output( filename.c_str(), std::ios_base::binary );
 		input.exceptions( std::ios::badbit );
-		output.exceptions( std::ios::badbit );
 
 		boost::iostreams::filtering_ostream out;
 
@@ -312,8 +377,7 @@ public:
 			out.push( _internal::progress_filter( *progress ) );
 		}
 
-		if( suffix == ".gz" )out.push( boost::iostreams::gzip_compressor() );
-		else if( suffix == ".bz2" )out.push( boost::iostreams::bzip2_compressor() );
+		if( suffix == ".bz2" )out.push( boost::iostreams::bzip2_compressor() );
 		else if( suffix == ".Z" )out.push( boost::iostreams::zlib_compressor() );
 
 #ifdef HAVE_LZMA
@@ -0,0 +1,192 @@
+#include "imageFormat_compressed_bgzf.hpp"
+#include <CoreUtils/threadpool.hpp>
+#include <DataStorage/common.hpp>
+#include <zlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <boost/lexical_cast.hpp>
+
+namespace isis
+{
+namespace image_io
+{
+namespace _internal
+{
+
+namespace
+{
+// see the SAM/BAM format specification (http://samtools.github.io/hts-specs/SAMv1.pdf)
+const size_t bgzf_block_size = 0xff00; // uncompressed size of a member, chosen by bgzip so that the compressed member never exceeds 64k
+const size_t bgzf_header_size = 18, bgzf_footer_size = 8, bgzf_max_member_size = 0x10000;
+const uint8_t bgzf_header[bgzf_header_size] = {
+	31, 139, 8, 4, // gzip magic, deflate, FEXTRA
+	0, 0, 0, 0, 0, 255, // no mtime, no extra flags, unknown os
+	6, 0, 'B', 'C', 2, 0, // 6 bytes of extra field, holding the subfield "BC" with 2 bytes
+	0, 0 // the size of the member -1 (set for each member)
+};
+const uint8_t bgzf_eof[28] = { // an empty member marks the end of the file
+	31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 'B', 'C', 2, 0, 27, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+void putLE( uint8_t *dst, uint32_t value, int bytes )
+{
+	for( int i = 0; i < bytes; i++, value >>= 8 )
+		dst[i] = value & 0xff;
+}
+uint32_t getLE( const uint8_t *src, int bytes )
+{
+	uint32_t ret = 0;
+
+	for( int i = bytes - 1; i >= 0; i-- )
+		ret = ret << 8 | src[i];
+
+	return ret;
+}
+
+// compresses the members [start,end) into out[block]
+struct CompressMembers {
+	const uint8_t *data;
+	size_t len;
+	std::vector<std::string> *out;
+	util::ProgressFeedback *progress;
+	void operator()( size_t block, size_t start, size_t end )const {
+		z_stream strm;
+		memset( &strm, 0, sizeof( strm ) );
+
+		if( deflateInit2( &strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY ) != Z_OK ) // raw deflate, the gzip header is written here
+			throw std::runtime_error( "Failed to initialize zlib for compression" );
+
+		std::string &dst = ( *out )[block];
+		uint8_t member[bgzf_max_member_size];
+
+		for( size_t m = start; m < end; m++ ) {
+			const size_t offset = m * bgzf_block_size, size = std::min( bgzf_block_size, len - offset );
+			deflateReset( &strm );
+			strm.next_in = const_cast<Bytef *>( data + offset );
+			strm.avail_in = size;
+			strm.next_out = member + bgzf_header_size;
+			strm.avail_out = bgzf_max_member_size - bgzf_header_size - bgzf_footer_size;
+
+			if( deflate( &strm, Z_FINISH ) != Z_STREAM_END ) {
+				deflateEnd( &strm );
+				throw std::runtime_error( "Failed to compress a block" ); // cannot happen, incompressible data only grow by a few bytes
+			}
+
+			const size_t member_size = bgzf_header_size + strm.total_out + bgzf_footer_size;
+			memcpy( member, bgzf_header, bgzf_header_size );
+			putLE( member + 16, member_size - 1, 2 );
+			putLE( member + bgzf_header_size + strm.total_out, crc32( crc32( 0, Z_NULL, 0 ), data + offset, size ), 4 );
+			putLE( member + bgzf_header_size + strm.total_out + 4, size, 4 );
+			dst.append( reinterpret_cast<const char *>( member ), member_size );
+		}
+
+		deflateEnd( &strm );
+
+		if( progress )
+			progress->progress( "", ( end - start ) * bgzf_block_size / 0x40000 ); // the steps of progress_filter
+	}
+};
+
+struct Member {size_t src, src_len, dst, dst_len; uint32_t crc;};
+
+// decompresses the members [start,end)
+struct DecompressMembers {
+	const uint8_t *src;
+	uint8_t *dst;
+	const Member *members;
+	void operator()( size_t /*block*/, size_t start, size_t end )const {
+		z_stream strm;
+		memset( &strm, 0, sizeof( strm ) );
+
+		if( inflateInit2( &strm, -15 ) != Z_OK )
+			throw std::runtime_error( "Failed to initialize zlib for decompression" );
+
+		for( size_t m = start; m < end; m++ ) {
+			const Member &mem = members[m];
+			inflateReset( &strm );
+			strm.next_in = const_cast<Bytef *>( src + mem.src );
+			strm.avail_in = mem.src_len;
+			strm.next_out = dst + mem.dst;
+			strm.avail_out = mem.dst_len;
+
+			if( inflate( &strm, Z_FINISH ) != Z_STREAM_END || strm.total_out != mem.dst_len || crc32( crc32( 0, Z_NULL, 0 ), dst + mem.dst, mem.dst_len ) != mem.crc ) {
+				inflateEnd( &strm );
+				throw std::runtime_error( "Corrupt gzip member at byte " + boost::lexical_cast<std::string>( mem.src ) );
+			}
+		}
+
+		inflateEnd( &strm );
+	}
+};
+}
+
+void bgzfCompress( const uint8_t *data, size_t len, std::ostream &out, boost::shared_ptr<util::ProgressFeedback> progress )
+{
+	util::ThreadPool &pool = util::ThreadPool::global();
+	const size_t members = ( len + bgzf_block_size - 1 ) / bgzf_block_size;
+	std::vector<std::string> compressed( pool.getBlocks( members, 16 ) );
+	boost::shared_ptr<util::ProgressFeedback> locked;
+
+	if( progress )
+		locked.reset( new util::LockedFeedback( progress ) );
+
+	const CompressMembers op = {data, len, &compressed, locked.get()};
+	pool.forEachBlock( members, 16, op );
+
+	for( std::vector<std::string>::const_iterator i = compressed.begin(); i != compressed.end(); ++i )
+		out.write( i->data(), i->size() );
+
+	out.write( reinterpret_cast<const char *>( bgzf_eof ), sizeof( bgzf_eof ) );
+}
+
+bool bgzfDecompress( const data::ValueArray<uint8_t> &file, data::ValueArray<uint8_t> &dst )
+{
+	const size_t len = file.getLength();
+
+	if( len == 0 )
+		return false;
+
+	const uint8_t *const src = &file[0];
+	std::vector<Member> members;
+	size_t total = 0;
+
+	// find the members, all of them must carry their size like the ones written by bgzfCompress
+	for( size_t pos = 0; pos < len; ) {
+		if( len - pos < bgzf_header_size + bgzf_footer_size ||
+			memcmp( src + pos, bgzf_header, 4 ) != 0 || memcmp( src + pos + 10, bgzf_header + 10, 6 ) != 0 ) {
+			LOG_IF( pos, Debug, warning ) << "Stopped reading gzip members in parallel at byte " << pos << ", because the member there has no size";
+			return false;
+		}
+
+		const size_t member_size = getLE( src + pos + 16, 2 ) + 1; // BSIZE is the size of the member -1
+
+		if( member_size < bgzf_header_size + bgzf_footer_size )
+			throw std::runtime_error( "The gzip member at byte " + boost::lexical_cast<std::string>( pos ) + " has an invalid size" );
+
+		if( member_size > len - pos )
+			throw std::runtime_error( "The gzip member at byte " + boost::lexical_cast<std::string>( pos ) + " is truncated" );
+
+		const Member mem = {pos + bgzf_header_size, member_size - bgzf_header_size - bgzf_footer_size, total, 0, 0};
+
+		members.push_back( mem );
+		members.back().crc = getLE( src + mem.src + mem.src_len, 4 );
+		members.back().dst_len = getLE( src + mem.src + mem.src_len + 4, 4 );
+		total += members.back().dst_len;
+		pos = mem.src + mem.src_len + bgzf_footer_size;
+	}
+
+	if( total == 0 ) // nothing to do in parallel
+		return false;
+
+	LOG( Debug, info ) << "Decompressing " << members.size() << " gzip members into " << total << " bytes in parallel";
+
+	data::ValueArray<uint8_t> ret( total );
+	const DecompressMembers op = {src, &ret[0], &members[0]};
+	util::ThreadPool::global().forEachBlock( members.size(), 16, op );
+	dst = ret;
+	return true;
+}
+
+}
+}
+}
@@ -0,0 +1,38 @@
+#ifndef IMAGEFORMAT_COMPRESSED_BGZF_HPP
+#define IMAGEFORMAT_COMPRESSED_BGZF_HPP
+
+#include <DataStorage/valuearray.hpp>
+#include <CoreUtils/progressfeedback.hpp>
+#include <ostream>
+
+namespace isis
+{
+namespace image_io
+{
+namespace _internal
+{
+/**
+ * Compress data as BGZF and write it to the given stream.
+ * BGZF (the blocked gzip of samtools/htslib) is a series of independent gzip members of up to 64k each.
+ * So it is a valid gzip file, which every gzip reader can decompress, but the members can be compressed and decompressed in parallel.
+ * The members are compressed by util::ThreadPool::global().
+ * \param data the data to be compressed
+ * \param len the length of the data in bytes
+ * \param out the stream to write the compressed data to
+ * \param progress if set, it is advanced by one step for every progress_filter::blocksize bytes compressed
+ */
+void bgzfCompress( const uint8_t *data, size_t len, std::ostream &out, boost::shared_ptr<util::ProgressFeedback> progress );
+
+/**
+ * Decompress a BGZF file in parallel.
+ * \param file the content of the compressed file
+ * \param dst the decompressed data (only set if true is returned)
+ * \returns false if the file is not BGZF (it has to be decompressed as a stream then), true otherwise
+ * \throws std::runtime_error if the file is BGZF but cannot be decompressed
+ */
+bool bgzfDecompress( const data::ValueArray<uint8_t> &file, data::ValueArray<uint8_t> &dst );
+}
+}
+}
+
+#endif // IMAGEFORMAT_COMPRESSED_BGZF_HPP
@@ -4,6 +4,7 @@
 
 #include "DataStorage/io_interface.h"
 #include <DataStorage/io_factory.hpp>
+#include <DataStorage/prefetcher.hpp>
 #include <fstream>
 
 namespace isis
@@ -36,18 +37,25 @@ public:
 		size_t red = 0;
 		const boost::regex linebreak( "[[.newline.][.carriage-return.]]" );
 		std::string fnames;
-		size_t fcnt = 0;
+		std::vector<boost::filesystem::path> files;
 
+		// get the whole list first, so the files can be read ahead while the ones before them are loaded
 		while( !in.eof() ) {
 			in >> fnames ;
 			BOOST_FOREACH( const std::string fname, util::stringToList<std::string>( fnames, linebreak ) ) {
-				LOG( Runtime, info ) << "loading " << fname;
-				red += data::IOFactory::load( chunks, fname, "", dialect );
-				fcnt++;
+				files.push_back( fname );
 			}
 		}
 
-		LOG_IF( fcnt == 0, Runtime, warning ) << "didn't get any filename from the input list";
+		LOG_IF( files.empty(), Runtime, warning ) << "didn't get any filename from the input list";
+
+		data::FilePrefetcher prefetcher( files );
+
+		for( size_t i = 0; i < files.size(); i++ ) {
+			LOG( Runtime, info ) << "loading " << files[i];
+			prefetcher.advance( i );
+			red += data::IOFactory::load( chunks, files[i].string(), "", dialect );
+		}
 
 		return red;
 	}
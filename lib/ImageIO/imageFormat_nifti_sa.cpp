@@ -72,22 +72,6 @@ bool WriteOp::operator()( data::Chunk &ch, util::vector4<size_t> posInImage )
 		return true;
 	}
 }
-void WriteOp::applyFlipToData ( data::ValueArrayReference &dat, util::vector4< size_t > chunkSize )
-{
-	if( !flip_list.empty() ) {
-		// wrap the copied part back into a Chunk to flip it
-		data::Chunk cp( dat, chunkSize[data::rowDim], chunkSize[data::columnDim], chunkSize[data::sliceDim], chunkSize[data::timeDim] ); // this is a cheap copy
-		applyFlipToData(cp); // and apply the flipping
-	}
-}
-void WriteOp::applyFlipToData ( data::Chunk &dat )
-{
-	//iterate through all flips within than the block dimensionality
-	for( std::set<data::dimensions>::const_iterator i = flip_list.begin(); i != flip_list.end() && *i < dat.getRelevantDims(); i++ ) {
-		dat.swapAlong( *i ); // .. so changing its data, will also change the data we just copied
-	}
-}
-
 void WriteOp::applyFlipToCoords ( util::vector4< size_t >& coords, data::dimensions blockdims )
 {
 	if( !flip_list.empty() ) {
@@ -112,10 +96,8 @@ public:
 		applyFlipToCoords( posInImage, ( data::dimensions )ch.getRelevantDims() );
 		size_t offset = m_voxelstart + getLinearIndex( posInImage ) * m_bpv / 8;
 		data::ValueArrayReference out_data = m_out.atByID( m_targetId, offset, ch.getVolume() );
-		ch.asValueArrayBase().copyTo( *out_data, m_scale );
-
-		applyFlipToData( out_data, ch.getSizeAsVector() );
-		return true;
+		// convert and flip straight into the mapped file (flips above the chunks dimensionality are done by the coords above)
+		return ch.copyToValueArray( *out_data, m_scale, flip_list );
 	}
 
 	short unsigned int getTypeId() {return m_targetId;}
@@ -682,8 +664,24 @@ int ImageFormat_NiftiSa::load ( std::list<data::Chunk> &chunks, const std::strin
 			throwGenericError( filename + " could not be opened" );
 	}
 
-	//get the header - we use it directly from the file
-	boost::shared_ptr< _internal::nifti_1_header > header = boost::static_pointer_cast<_internal::nifti_1_header>( mfile.getRawAddress() );
+	return doLoad( chunks, mfile, filename, dialect );
+}
+
+int ImageFormat_NiftiSa::load( std::list<data::Chunk> &chunks, const data::ValueArray<uint8_t> &data, const std::string &filename, const util::istring &dialect, boost::shared_ptr<util::ProgressFeedback> /*progress*/ )  throw( std::runtime_error & )
+{
+	data::FilePtr mfile( data );
+	return doLoad( chunks, mfile, filename, dialect );
+}
+
+int ImageFormat_NiftiSa::doLoad( std::list<data::Chunk> &chunks, data::FilePtr &mfile, const std::string &filename, const util::istring &dialect )
+{
+	if( mfile.getLength() < sizeof( _internal::nifti_1_header ) )
+		throwGenericError( filename + " is too small to be a nifti file" );
+
+	//get a copy of the header - so the fixes below don't cause copy-on-write of the mapped file
+	boost::shared_ptr< _internal::nifti_1_header > header(
+		new _internal::nifti_1_header( *boost::static_pointer_cast<const _internal::nifti_1_header>( mfile.getRawAddress() ) )
+	);
 	const bool swap_endian = checkSwapEndian( header );
 
 	if( header->sizeof_hdr < 348 ) {
@@ -722,6 +720,9 @@ int ImageFormat_NiftiSa::load ( std::list<data::Chunk> &chunks, const std::strin
 	size.copyFrom( header->dim + 1, header->dim + 1 + 4 );
 	data::ValueArrayReference data_src;
 
+	if( header->vox_offset < mfile.getLength() ) // the voxels are usually read from start to end (e.g. when converting or writing them), so start reading them in the background
+		mfile.advise( data::FilePtr::access_sequential | data::FilePtr::access_willneed, header->vox_offset );
+
 	if( header->datatype == NIFTI_TYPE_BINARY ) { // image is binary encoded - needs special decoding
 		data_src = bitRead( mfile.at<uint8_t>( header->vox_offset ), size.product() );
 	} else if( util::istring( "fsl" ) == dialect.c_str() && header->datatype == NIFTI_TYPE_UINT8 && size[data::timeDim] == 3 ) { //if its fsl-three-volume-color copy the volumes
@@ -140,8 +140,6 @@ protected:
 	WriteOp( const isis::data::Image &image, size_t bitsPerVoxel );
 	virtual bool doCopy( data::Chunk &ch, util::vector4<size_t> posInImage ) = 0;
 	void applyFlipToCoords ( util::vector4< size_t > &coords, data::dimensions blockdims );
-	void applyFlipToData ( data::ValueArrayReference &dat, util::vector4< size_t > chunkSize );
-	void applyFlipToData ( data::Chunk& dat );
 public:
 	virtual ~WriteOp() {}
 	nifti_1_header *getHeader();
@@ -188,6 +186,8 @@ class ImageFormat_NiftiSa: public FileFormat
 	data::ValueArray<bool> bitRead( isis::data::ValueArray< uint8_t > src, size_t length );
 	bool checkSwapEndian ( boost::shared_ptr< _internal::nifti_1_header > header );
 	void flipGeometry( data::Image &image, data::dimensions flipdim );
+	// parses the file (or the memory) given as mfile, filename is only used for messages
+	int doLoad( std::list<data::Chunk> &chunks, data::FilePtr &mfile, const std::string &filename, const util::istring &dialect );
 	void translateFromDcmMetaConst( util::PropertyMap& orig );
 	void translateFromDcmMetaSlices( util::PropertyMap& orig );
 	void translateToDcmMetaConst( util::PropertyMap& orig, std::ofstream &output );
@@ -197,6 +197,7 @@ public:
 	ImageFormat_NiftiSa();
 	std::string getName()const;
 	int load ( std::list<data::Chunk> &chunks, const std::string &filename, const util::istring &/*dialect*/, boost::shared_ptr<util::ProgressFeedback> progress )  throw( std::runtime_error & );
+	int load( std::list<data::Chunk> &chunks, const data::ValueArray<uint8_t> &data, const std::string &filename, const util::istring &dialect, boost::shared_ptr<util::ProgressFeedback> progress )  throw( std::runtime_error & );
 	void write( const data::Image &image, const std::string &filename, const util::istring &dialect, boost::shared_ptr<util::ProgressFeedback> progress )  throw( std::runtime_error & );
 	bool tainted()const {return false;}//internal plugins are not tainted
 	util::istring dialects( const std::string &/*filename*/ )const {return "fsl spm withExtProtocols";}
@@ -0,0 +1,87 @@
+#define BOOST_TEST_MODULE MessageTest
+#include <boost/test/unit_test.hpp>
+#include "CoreUtils/log.hpp"
+#include "CoreUtils/common.hpp"
+#include "CoreUtils/threadpool.hpp"
+#include <boost/lexical_cast.hpp>
+
+namespace isis
+{
+namespace test
+{
+
+void logMany( size_t job, size_t count )
+{
+	for( size_t i = 0; i < count; i++ )
+		LOG( util::Runtime, notice ) << "message " << i << " from job " << job;
+}
+
+BOOST_AUTO_TEST_CASE( async_log_test )
+{
+	std::ostringstream out;
+	util::DefaultMsgPrint::setStream( out );
+
+	boost::shared_ptr<util::AsyncMsgPrint> handler( new util::AsyncMsgPrint( notice ) );
+	util::_internal::Log<util::Runtime>::setHandler( handler );
+
+	util::ThreadPool pool( 4 );
+	std::vector<util::ThreadPool::job> jobs;
+
+	for( size_t j = 0; j < 8; j++ )
+		jobs.push_back( boost::bind( logMany, j, 100 ) );
+
+	pool.run( jobs );
+	handler->flush();
+
+	// all messages are there, and the messages of each job are in order
+	const std::string written = out.str();
+
+	for( size_t j = 0; j < 8; j++ ) {
+		size_t pos = 0;
+
+		for( size_t i = 0; i < 100; i++ ) {
+			const std::string msg = "message " + boost::lexical_cast<std::string>( i ) + " from job " + boost::lexical_cast<std::string>( j ) + "\n";
+			pos = written.find( msg, pos );
+			BOOST_REQUIRE_NE( pos, std::string::npos );
+		}
+	}
+
+	BOOST_CHECK_EQUAL( std::count( written.begin(), written.end(), '\n' ), 800 );
+
+	// errors are written before LOG returns
+	LOG( util::Runtime, error ) << "an error";
+	BOOST_CHECK_NE( out.str().find( "an error" ), std::string::npos );
+
+	util::_internal::Log<util::Runtime>::setHandler( boost::shared_ptr<util::MessageHandlerBase>() );
+	util::DefaultMsgPrint::setStream( std::cerr );
+}
+
+size_t evaluated = 0;
+size_t evaluate()
+{
+	return ++evaluated;
+}
+
+BOOST_AUTO_TEST_CASE( disabled_log_test )
+{
+	std::ostringstream out;
+	util::DefaultMsgPrint::setStream( out );
+	util::_internal::Log<util::Runtime>::setHandler( boost::shared_ptr<util::MessageHandlerBase>( new util::DefaultMsgPrint( notice ) ) );
+
+	// the arguments of messages below the level of the handler are not evaluated
+	LOG( util::Runtime, info ) << "disabled message " << evaluate();
+	LOG_IF( evaluate(), util::Runtime, verbose_info ) << "disabled message " << evaluate();
+	BOOST_CHECK_EQUAL( evaluated, 0 );
+	BOOST_CHECK( out.str().empty() );
+
+	// the arguments of enabled messages are
+	LOG( util::Runtime, notice ) << "enabled message " << evaluate();
+	BOOST_CHECK_EQUAL( evaluated, 1 );
+	BOOST_CHECK_NE( out.str().find( "enabled message 1" ), std::string::npos );
+
+	util::_internal::Log<util::Runtime>::setHandler( boost::shared_ptr<util::MessageHandlerBase>() );
+	util::DefaultMsgPrint::setStream( std::cerr );
+}
+
+}
+}
@@ -39,6 +39,24 @@ BOOST_AUTO_TEST_CASE( propMap_init_test )
 	BOOST_CHECK( map1.propertyValue( "new" ).isEmpty() );
 }
 
+BOOST_AUTO_TEST_CASE( propMap_path_test )
+{
+	const std::list<util::PropertyMap::KeyType> expected = util::stringToList<util::PropertyMap::KeyType>( util::istring( "path/to/entry" ), '/' );
+
+	// empty keys are skipped, paths from c-strings and from keys are the same
+	const util::PropertyMap::PropPath fromCString( "/path/to//entry/" );
+	const util::PropertyMap::PropPath fromKey( util::PropertyMap::KeyType( "path//to/entry" ) );
+	BOOST_CHECK_EQUAL_COLLECTIONS( fromCString.begin(), fromCString.end(), expected.begin(), expected.end() );
+	BOOST_CHECK_EQUAL_COLLECTIONS( fromKey.begin(), fromKey.end(), expected.begin(), expected.end() );
+	BOOST_CHECK( util::PropertyMap::PropPath( "" ).empty() );
+	BOOST_CHECK( util::PropertyMap::PropPath( "//" ).empty() );
+
+	util::PropertyMap map;
+	map.setPropertyAs( "Path/To/Entry", 1 );
+	BOOST_CHECK( map.hasProperty( fromCString ) );
+	BOOST_CHECK( map.hasProperty( fromKey ) );
+}
+
 BOOST_AUTO_TEST_CASE( propMap_set_test )
 {
 	util::PropertyMap map1;
@@ -75,6 +93,55 @@ BOOST_AUTO_TEST_CASE( propMap_remove_test )
 	BOOST_CHECK( map.branch( "sub" ).isEmpty() ); //not anymore (this will create an "normal" empty entry)
 }
 
+BOOST_AUTO_TEST_CASE( propMap_copy_test )
+{
+	util::PropertyMap org;
+	org.propertyValue( "Test1" ) = 6.4;
+	org.propertyValue( "sub/Test1" ) = ( int32_t )1;
+	org.propertyValue( "sub/subsub/Test1" ) = std::string( "Hallo" );
+
+	// copies share their branches until they are changed
+	util::PropertyMap copy = org;
+	BOOST_CHECK_EQUAL( copy.propertyValue( "sub/subsub/Test1" ), std::string( "Hallo" ) );
+	copy.propertyValue( "sub/subsub/Test1" ) = std::string( "Hallo Welt" );
+	copy.propertyValue( "sub/Test2" ) = ( int32_t )2;
+	BOOST_CHECK_EQUAL( org.propertyValue( "sub/subsub/Test1" ), std::string( "Hallo" ) );
+	BOOST_CHECK( !org.hasProperty( "sub/Test2" ) );
+	BOOST_CHECK_EQUAL( copy.propertyValue( "sub/subsub/Test1" ), std::string( "Hallo Welt" ) );
+
+	// and that works in both directions
+	copy = org;
+	org.remove( "sub/Test1" );
+	BOOST_CHECK( copy.hasProperty( "sub/Test1" ) );
+
+	// writing through a reference held while copying only changes the map it was got from
+	util::PropertyValue &held = org.propertyValue( "sub/subsub/Test1" );
+	util::PropertyMap &heldBranch = org.branch( "sub" );
+	copy = org;
+	BOOST_CHECK_NE( &static_cast<const util::PropertyMap &>( copy ).propertyValue( "sub/subsub/Test1" ), &held );
+	held = std::string( "Hallo Welt" );
+	heldBranch.propertyValue( "Test3" ) = ( int32_t )3;
+	BOOST_CHECK_EQUAL( org.propertyValue( "sub/subsub/Test1" ), std::string( "Hallo Welt" ) );
+	BOOST_CHECK( org.hasProperty( "sub/Test3" ) );
+	BOOST_CHECK_EQUAL( copy.propertyValue( "sub/subsub/Test1" ), std::string( "Hallo" ) );
+	BOOST_CHECK( !copy.hasProperty( "sub/Test3" ) );
+
+	// and the same goes for a reference into the copy
+	util::PropertyValue &heldInCopy = copy.propertyValue( "sub/subsub/Test1" );
+	org = copy;
+	heldInCopy = std::string( "Hallo Welt" );
+	BOOST_CHECK_EQUAL( copy.propertyValue( "sub/subsub/Test1" ), std::string( "Hallo Welt" ) );
+	BOOST_CHECK_EQUAL( org.propertyValue( "sub/subsub/Test1" ), std::string( "Hallo" ) );
+
+	// shared branches are equal and removed completely (org handed out its branches, but its copies share theirs)
+	const util::PropertyMap shared = org;
+	copy = shared;
+	BOOST_CHECK( copy.getDifference( shared ).empty() );
+	BOOST_CHECK( copy.remove( shared ) );
+	BOOST_CHECK( copy.isEmpty() );
+	BOOST_CHECK( shared.hasProperty( "sub/subsub/Test1" ) );
+}
+
 BOOST_AUTO_TEST_CASE( propMap_join_test )
 {
 	util::PropertyMap map1, map2, result, org;
@@ -1,11 +1,13 @@
 #include "CoreUtils/singletons.hpp"
 #include <iostream>
+#include <boost/thread/thread.hpp>
 
 
 namespace isis
 {
 namespace test
 {
+using util::Singletons;
 
 template<int NUMBER> class SingleTest
 {
@@ -17,6 +19,24 @@ public:
 		std::cout << "Deleting SingleTest<" << NUMBER << ">" << std::endl;
 	}
 };
+
+// takes a while to be created, so concurrent first calls of get() will overlap
+class SlowSingle
+{
+public:
+	static int created;
+	SlowSingle() {
+		boost::this_thread::sleep( boost::posix_time::milliseconds( 50 ) );
+		created++;
+	}
+};
+int SlowSingle::created = 0;
+
+SlowSingle *slow_results[8];
+void getSlow( int idx )
+{
+	slow_results[idx] = &Singletons::get<SlowSingle, 5>();
+}
 }
 }
 using namespace isis::util;
@@ -33,4 +53,23 @@ int main()
 
 	if ( ( void * )&s1 == ( void * )&Singletons::get<SingleTest<3>, 5>() ) // this should be deleted before SingleTest<2>
 		std::cerr << "request for SingleTest<3> gets Singleton1" << std::endl;
+
+	boost::thread_group threads;
+
+	for( int i = 0; i < 8; i++ )
+		threads.create_thread( boost::bind( getSlow, i ) );
+
+	threads.join_all();
+
+	for( int i = 1; i < 8; i++ ) {
+		if ( slow_results[i] != slow_results[0] ) {
+			std::cerr << "concurrent requests for SlowSingle got different objects" << std::endl;
+			return 1;
+		}
+	}
+
+	if ( SlowSingle::created != 1 ) {
+		std::cerr << "SlowSingle was created " << SlowSingle::created << " times" << std::endl;
+		return 1;
+	}
 }
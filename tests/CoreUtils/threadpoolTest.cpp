@@ -0,0 +1,84 @@
+#define BOOST_TEST_MODULE ThreadPoolTest
+#include <boost/test/unit_test.hpp>
+#include "CoreUtils/threadpool.hpp"
+#include <numeric>
+
+namespace isis
+{
+namespace test
+{
+
+struct BlockSum {
+	const std::vector<size_t> *values;
+	std::vector<size_t> *sums;
+	void operator()( size_t block, size_t start, size_t end )const {
+		( *sums )[block] = std::accumulate( values->begin() + start, values->begin() + end, size_t( 0 ) );
+	}
+};
+
+void add( boost::mutex &mutex, size_t &target, size_t value )
+{
+	boost::lock_guard<boost::mutex> lock( mutex );
+	target += value;
+}
+
+void throwing()
+{
+	throw std::logic_error( "job failed" );
+}
+
+void nested( util::ThreadPool &pool, boost::mutex &mutex, size_t &target )
+{
+	std::vector<util::ThreadPool::job> jobs;
+
+	for( size_t i = 0; i < 10; i++ )
+		jobs.push_back( boost::bind( add, boost::ref( mutex ), boost::ref( target ), 1 ) );
+
+	pool.run( jobs );
+}
+
+BOOST_AUTO_TEST_CASE( threadpool_blocks_test )
+{
+	util::ThreadPool pool( 4 ), single( 1 );
+	BOOST_CHECK_EQUAL( pool.getConcurrency(), 4 );
+	BOOST_CHECK_EQUAL( single.getConcurrency(), 1 );
+
+	// splitting is only done if its worth it
+	BOOST_CHECK_EQUAL( pool.getBlocks( 100, 100 ), 1 );
+	BOOST_CHECK_EQUAL( pool.getBlocks( 1000, 100 ), 10 );
+	BOOST_CHECK_EQUAL( pool.getBlocks( 100000, 100 ), 16 );
+	BOOST_CHECK_EQUAL( single.getBlocks( 100000, 100 ), 1 );
+
+	std::vector<size_t> values( 100003 );
+
+	for( size_t i = 0; i < values.size(); i++ )
+		values[i] = i;
+
+	std::vector<size_t> sums( pool.getBlocks( values.size(), 100 ) );
+	const BlockSum op = {&values, &sums};
+	pool.forEachBlock( values.size(), 100, op );
+
+	BOOST_CHECK_EQUAL( std::accumulate( sums.begin(), sums.end(), size_t( 0 ) ), values.size() * ( values.size() - 1 ) / 2 );
+}
+
+BOOST_AUTO_TEST_CASE( threadpool_run_test )
+{
+	util::ThreadPool pool( 4 );
+	boost::mutex mutex;
+	size_t result = 0;
+
+	// jobs which run jobs on the same pool must not deadlock
+	std::vector<util::ThreadPool::job> jobs;
+
+	for( size_t i = 0; i < 20; i++ )
+		jobs.push_back( boost::bind( nested, boost::ref( pool ), boost::ref( mutex ), boost::ref( result ) ) );
+
+	pool.run( jobs );
+	BOOST_CHECK_EQUAL( result, 200 );
+
+	// exceptions are passed on to the caller
+	jobs.push_back( throwing );
+	BOOST_CHECK_THROW( pool.run( jobs ), std::runtime_error );
+}
+}
+}
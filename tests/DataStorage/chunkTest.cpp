@@ -96,6 +96,47 @@ BOOST_AUTO_TEST_CASE ( chunk_foreach_voxel_test )
 	BOOST_CHECK_EQUAL( ch.foreachVoxel( check ), 0 ); // now they all should be
 }
 
+namespace
+{
+struct EncodePos {
+	bool operator()( uint32_t &vox, const util::vector4<size_t>& pos ) {
+		vox = pos[data::rowDim] + 10 * pos[data::columnDim] + 100 * pos[data::sliceDim] + 1000 * pos[data::timeDim];
+		return true;
+	}
+};
+struct IsOdd {
+	bool operator()( int16_t &vox, const util::vector4<size_t>& /*pos*/ ) {
+		return vox % 2;
+	}
+};
+}
+
+BOOST_AUTO_TEST_CASE ( chunk_forEachVoxel_test )
+{
+	data::MemChunk<int16_t> ch( 4, 3, 2, 2 );
+
+	for( size_t i = 0; i < ch.getVolume(); i++ )
+		ch.asValueArray<int16_t>()[i] = i;
+
+	IsOdd odd;
+	BOOST_CHECK_EQUAL( data::forEachVoxel<int16_t>( ch, odd ), ch.getVolume() / 2 );
+
+	// wrong type => nothing is done and everything failed
+	EncodePos encode;
+	BOOST_CHECK_EQUAL( data::forEachVoxel<uint32_t>( ch, encode ), ch.getVolume() );
+
+	// positions are given in memory order and have the offset added
+	data::MemChunk<uint32_t> posCh( 4, 3, 2, 2 );
+	BOOST_CHECK_EQUAL( data::forEachVoxel<uint32_t>( posCh, encode, util::vector4<size_t>( 1, 2, 3, 4 ) ), 0 );
+
+	for( size_t i = 0; i < posCh.getVolume(); i++ ) {
+		size_t d[4];
+		posCh.getCoordsFromLinIndex( i, d );
+		BOOST_CHECK_EQUAL( posCh.voxel<uint32_t>( d[0], d[1], d[2], d[3] ), ( d[0] + 1 ) + 10 * ( d[1] + 2 ) + 100 * ( d[2] + 3 ) + 1000 * ( d[3] + 4 ) );
+		BOOST_CHECK_EQUAL( posCh.asValueArray<uint32_t>()[i], posCh.voxel<uint32_t>( d[0], d[1], d[2], d[3] ) );
+	}
+}
+
 BOOST_AUTO_TEST_CASE ( chunk_mem_init_test )
 {
 	const short data[3 * 3] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
@@ -329,6 +370,39 @@ BOOST_AUTO_TEST_CASE ( chunk_splice_test )//Copy chunks
 	}
 }
 
+BOOST_AUTO_TEST_CASE ( chunk_splice_props_test )
+{
+	data::MemChunk<float> ch1( 3, 3, 3 );
+	ch1.setPropertyAs( "indexOrigin", util::fvector3( 1, 1, 1 ) );
+	ch1.setPropertyAs( "rowVec", util::fvector3( 1, 0, 0 ) );
+	ch1.setPropertyAs( "columnVec", util::fvector3( 0, 1, 0 ) );
+	ch1.setPropertyAs( "voxelSize", util::fvector3( 1, 1, 1 ) );
+	ch1.setPropertyAs<uint32_t>( "acquisitionNumber", 0 );
+	ch1.setPropertyAs( "DICOM/common", std::string( "common" ) );
+
+	for ( size_t i = 0; i < 3; i++ ) {
+		ch1.propertyValueAt( "acquisitionTime", i ) = float( i );
+		ch1.propertyValueAt( "DICOM/list", i ) = int32_t( i * 2 );
+	}
+
+	std::list<data::Chunk> splices = ch1.autoSplice( );
+	BOOST_REQUIRE_EQUAL( splices.size(), 3 );
+	int cnt = 0;
+	BOOST_FOREACH( const data::Chunk & ref, splices ) { // every splice gets its entry of the lists and all other properties
+		BOOST_CHECK_EQUAL( ref.propertyValue( "acquisitionTime" ), float( cnt ) );
+		BOOST_CHECK_EQUAL( ref.propertyValue( "DICOM/list" ), int32_t( cnt * 2 ) );
+		BOOST_CHECK_EQUAL( ref.propertyValue( "DICOM/common" ), std::string( "common" ) );
+		BOOST_CHECK( ref.findLists().empty() );
+		cnt++;
+	}
+
+	// changing the properties of one splice does not change the others or the original
+	splices.front().setPropertyAs( "DICOM/common", std::string( "changed" ) );
+	BOOST_CHECK_EQUAL( splices.back().propertyValue( "DICOM/common" ), std::string( "common" ) );
+	BOOST_CHECK_EQUAL( ch1.propertyValue( "DICOM/common" ), std::string( "common" ) );
+	BOOST_CHECK_EQUAL( static_cast<const data::Chunk &>( ch1 ).propertyValueAt( "DICOM/list", 2 ), int32_t( 4 ) );
+}
+
 BOOST_AUTO_TEST_CASE ( chunk_swap_test )
 {
 	class : public data::VoxelOp<int>
@@ -373,6 +447,43 @@ BOOST_AUTO_TEST_CASE ( chunk_swap_test )
 	}
 }
 
+BOOST_AUTO_TEST_CASE ( chunk_copyToValueArray_test )
+{
+	// small chunks are converted as a whole and flipped in place, big ones are flipped while converting
+	const size_t sizes[][4] = {{5, 6, 7, 3}, {70, 80, 3, 2}, {4100, 3, 2, 1}};
+	const data::dimensions dims[] = {data::rowDim, data::columnDim, data::sliceDim, data::timeDim};
+
+	for( size_t s = 0; s < 3; s++ ) {
+		data::MemChunk<int16_t> ch( sizes[s][0], sizes[s][1], sizes[s][2], sizes[s][3] );
+
+		for( size_t i = 0; i < ch.getVolume(); i++ )
+			ch.asValueArray<int16_t>()[i] = i % 30000;
+
+		for( unsigned short mask = 0; mask < 16; mask++ ) { // all combinations of flips
+			std::set<data::dimensions> flips;
+			data::Chunk ref = ch.copyByID( data::ValueArray<int32_t>::staticID );
+
+			for( int d = 0; d < 4; d++ ) {
+				if( mask & ( 1 << d ) ) {
+					flips.insert( dims[d] );
+					ref.swapAlong( dims[d] );
+				}
+			}
+
+			data::ValueArray<int32_t> dst( ch.getVolume() + 1 );
+			dst[ch.getVolume()] = -1;
+			BOOST_REQUIRE( ch.copyToValueArray( dst, data::scaling_pair(), flips ) );
+			BOOST_CHECK_EQUAL( ref.getValueArrayBase().compare( 0, ch.getVolume() - 1, dst, 0 ), 0 );
+			BOOST_CHECK_EQUAL( dst[ch.getVolume()], -1 ); // nothing is written behind the chunks volume
+		}
+	}
+
+	// too short destinations are rejected
+	data::MemChunk<int16_t> ch( 5, 6, 7 );
+	data::ValueArray<int32_t> dst( ch.getVolume() - 1 );
+	BOOST_CHECK( !ch.copyToValueArray( dst ) );
+}
+
 BOOST_AUTO_TEST_CASE ( chunk_copySlice_Test )
 {
 	size_t rows = 13;
@@ -3,6 +3,7 @@
 
 #include <CoreUtils/tmpfile.hpp>
 #include <DataStorage/fileptr.hpp>
+#include <DataStorage/prefetcher.hpp>
 #define BOOST_FILESYSTEM_VERSION 3 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -118,5 +119,115 @@ BOOST_AUTO_TEST_CASE( FilePtr_at_test )
 
 }
 
+BOOST_AUTO_TEST_CASE( FilePtr_advise_test )
+{
+	util::TmpFile testfile;
+	const size_t size = 1024 * 1024 + 5; // not a multiple of the page size
+	{
+		data::FilePtr fptr( testfile, size, true );
+		BOOST_REQUIRE( fptr.good() );
+
+		for( size_t i = 0; i < size; i++ )
+			fptr[i] = i % 251;
+	}
+
+	// all hints can be given when mapping (they are ignored where they are not supported)
+	data::FilePtr fptr( testfile, 0, false, data::FilePtr::access_populate | data::FilePtr::access_sequential | data::FilePtr::access_hugepages );
+	BOOST_REQUIRE( fptr.good() );
+	BOOST_REQUIRE_EQUAL( fptr.getLength(), size );
+
+	// and changed later for parts of the file which don't have to start at a page
+	BOOST_CHECK( fptr.advise( data::FilePtr::access_random, 4097, 1000 ) );
+	BOOST_CHECK( fptr.advise( data::FilePtr::access_willneed | data::FilePtr::access_populate, 5 ) );
+	BOOST_CHECK( fptr.advise( data::FilePtr::access_normal ) );
+
+	// ranges outside of the file are refused
+	BOOST_CHECK( !fptr.advise( data::FilePtr::access_random, size ) );
+	BOOST_CHECK( !fptr.advise( data::FilePtr::access_random, 10, size ) );
+
+	// the content is not changed by any of it
+	bool same = true;
+
+	for( size_t i = 0; i < size; i++ )
+		same &= fptr[i] == i % 251;
+
+	BOOST_CHECK( same );
+}
+
+BOOST_AUTO_TEST_CASE( FilePtr_read_mode_test )
+{
+	util::TmpFile testfile;
+	const size_t size = 9 * 1024 * 1024 + 7; // more than one block, and not a multiple of the page size
+	{
+		data::FilePtr fptr( testfile, size, true );
+		BOOST_REQUIRE( fptr.good() );
+
+		for( size_t i = 0; i < size; i++ )
+			fptr[i] = i % 251;
+	}
+
+	const data::FilePtr::readMode modes[] = {data::FilePtr::read_mmap, data::FilePtr::read_pread, data::FilePtr::read_direct};
+
+	for( int m = 0; m < 3; m++ ) {
+		data::FilePtr fptr( testfile, 0, false, data::FilePtr::access_normal, modes[m] );
+		BOOST_REQUIRE( fptr.good() );
+		BOOST_REQUIRE_EQUAL( fptr.getLength(), size );
+
+		bool same = true;
+
+		for( size_t i = 0; i < size; i++ )
+			same &= fptr[i] == i % 251;
+
+		BOOST_CHECK( same );
+
+		// the interface is the same for all modes
+		data::ValueArray<uint8_t> part = fptr.at<uint8_t>( size - 2 );
+		BOOST_REQUIRE_EQUAL( part.getLength(), 2 );
+		BOOST_CHECK_EQUAL( part[1], ( size - 1 ) % 251 );
+		part[1] = 0; // writing into the memory does not change the file
+	}
+
+	// without an explicit mode the default is used
+	const data::FilePtr::readMode old_mode = data::FilePtr::getDefaultReadMode();
+	data::FilePtr::setDefaultReadMode( data::FilePtr::read_pread );
+	BOOST_CHECK_EQUAL( data::FilePtr::getDefaultReadMode(), data::FilePtr::read_pread );
+	data::FilePtr fptr( testfile );
+	BOOST_REQUIRE( fptr.good() );
+	BOOST_CHECK_EQUAL( fptr[size - 1], ( size - 1 ) % 251 );
+	data::FilePtr::setDefaultReadMode( old_mode );
+}
+
+BOOST_AUTO_TEST_CASE( FilePrefetcher_test )
+{
+	util::TmpFile testfile1, testfile2, testfile3;
+	{
+		data::FilePtr( testfile1, 4096, true );
+		data::FilePtr( testfile2, 4096, true );
+	}
+
+	std::vector<boost::filesystem::path> files;
+	files.push_back( testfile1 );
+	files.push_back( testfile2 );
+	files.push_back( boost::filesystem::path( testfile2 ).parent_path() ); // directories are skipped
+	files.push_back( testfile3 ); // testfile3 is empty
+	files.push_back( "/this/file/does/not/exist" ); // that is for the loader to complain about
+
+	data::FilePrefetcher prefetcher( files, 2 );
+	BOOST_CHECK_EQUAL( prefetcher.getIssued(), 0 );
+
+	prefetcher.advance( 0 ); // while the first file is loaded, the next two are read ahead
+	BOOST_CHECK_EQUAL( prefetcher.getIssued(), 3 );
+	prefetcher.advance( 0 );
+	BOOST_CHECK_EQUAL( prefetcher.getIssued(), 3 );
+	prefetcher.advance( 2 );
+	BOOST_CHECK_EQUAL( prefetcher.getIssued(), 5 );
+	prefetcher.advance( 4 ); // never goes behind the end of the list
+	BOOST_CHECK_EQUAL( prefetcher.getIssued(), 5 );
+
+	data::FilePrefetcher disabled( files, 0 );
+	disabled.advance( 0 );
+	BOOST_CHECK_EQUAL( disabled.getIssued(), 0 );
+}
+
 }
 }
@@ -50,5 +50,41 @@ BOOST_AUTO_TEST_CASE ( imageList_chunk_test )
 	}
 }
 
+/* chunks of different series, interleaved in the list*/
+BOOST_AUTO_TEST_CASE ( imageList_mixed_series_test )
+{
+	const uint16_t series = 4;
+	const size_t slices = 6;
+	std::list<data::Chunk> chunks;
+
+	for ( size_t s = 0; s < slices; s++ ) {
+		for ( uint16_t c = 0; c < series; c++ ) {
+			data::MemChunk<float> ch( 3, 3 );
+			ch.setPropertyAs( "indexOrigin", util::fvector3( 0, 0, slices - s ) ); // reverse order, so sorting is needed
+			ch.setPropertyAs( "acquisitionNumber",  ( uint32_t )s );
+			ch.setPropertyAs( "rowVec", util::fvector3( 1, 0 ) );
+			ch.setPropertyAs( "columnVec", util::fvector3( 0, 1 ) );
+			ch.setPropertyAs( "voxelSize", util::fvector3( 1, 1, 1 ) );
+			ch.setPropertyAs( "sequenceNumber", c );
+			ch.voxel<float>( 0, 0 ) = c * 100 + s;
+			chunks.push_back( ch );
+		}
+	}
+
+	std::list<data::Image> list = data::IOFactory::chunkListToImageList( chunks );
+	BOOST_CHECK( chunks.empty() );
+	BOOST_REQUIRE_EQUAL( list.size(), series );
+	uint16_t c = 0;
+	BOOST_FOREACH( data::Image & ref, list ) {
+		BOOST_CHECK( ref.getSizeAsVector() == util::fvector4( 3, 3, slices, 1 ) );
+		BOOST_CHECK_EQUAL( ref.getPropertyAs<uint16_t>( "sequenceNumber" ), c );
+
+		for ( size_t s = 0; s < slices; s++ )
+			BOOST_CHECK_EQUAL( ref.voxel<float>( 0, 0, s ), c * 100 + slices - 1 - s );
+
+		c++;
+	}
+}
+
 }
 }
@@ -436,6 +436,49 @@ BOOST_AUTO_TEST_CASE ( image_foreach_chunk_test )
 
 }
 
+namespace
+{
+class SetLinIdx
+{
+	data::_internal::NDimensional<4> geometry;
+public:
+	SetLinIdx( data::_internal::NDimensional<4> geo ): geometry( geo ) {}
+	bool operator()( uint16_t &vox, const util::vector4<size_t>& pos ) {
+		vox = geometry.getLinearIndex( &pos[0] );
+		return vox % 2 == 0; // fail on odd indexes
+	}
+};
+}
+
+BOOST_AUTO_TEST_CASE ( image_forEachVoxel_test )
+{
+	for( int parallel = 0; parallel < 2; parallel++ ) {
+		std::list<data::Chunk> chunks;
+
+		for ( int i = 0; i < 3; i++ )
+			for ( int j = 0; j < 3; j++ ) {
+				chunks.push_back( genSlice<uint8_t>( 3, 3, j, j + i * 3 ) );
+				chunks.back().voxel<uint8_t>( j, j ) = 42;
+			}
+
+		data::Image img( chunks );
+		SetLinIdx setidx( img );
+
+		// the uint8_t-chunks are converted to uint16_t, and every second voxel fails
+		BOOST_CHECK_EQUAL( data::forEachVoxel<uint16_t>( img, setidx, parallel ), img.getVolume() / 2 );
+		BOOST_CHECK( img.getMajorTypeID() == data::ValueArray<uint16_t>::staticID );
+
+		const util::vector4<size_t> imgSize = img.getSizeAsVector();
+		uint16_t cnt = 0;
+
+		for( size_t t = 0; t < imgSize[data::timeDim]; t++ )
+			for( size_t z = 0; z < imgSize[data::sliceDim]; z++ )
+				for( size_t y = 0; y < imgSize[data::columnDim]; y++ )
+					for( size_t x = 0; x < imgSize[data::rowDim]; x++ )
+						BOOST_CHECK_EQUAL( img.voxel<uint16_t>( x, y, z, t ), cnt++ );
+	}
+}
+
 BOOST_AUTO_TEST_CASE ( image_voxel_test )
 {
 	//  get a voxel from inside and outside the image
@@ -639,6 +682,125 @@ BOOST_AUTO_TEST_CASE ( typed_image_iterator_test )
 	BOOST_CHECK_EQUAL( std::distance( start, i ), img.getLinearIndex( util::vector4<size_t>( 1, 1, 1 ) ) ); //we should be exactly at the position of the second 42 now
 }
 
+BOOST_AUTO_TEST_CASE ( typed_image_segment_test )
+{
+	std::list<data::Chunk> chunks;
+
+	for( int i = 0; i < 3; i++ )
+		chunks.push_back( genSlice<float>( 3, 3, i, i ) );
+
+	data::TypedImage<float> img = data::Image( chunks );
+	BOOST_REQUIRE( img.isClean() );
+
+	// fill every chunk at once with the number of the chunk
+	float cnt = 0;
+	size_t segments = 0;
+
+	for( data::TypedImage<float>::iterator i = img.begin(); i != img.end(); i.nextSegment(), segments++ ) {
+		BOOST_CHECK_EQUAL( std::distance( i.local(), i.localEnd() ), 9 );
+		std::fill( i.local(), i.localEnd(), cnt++ );
+	}
+
+	BOOST_CHECK_EQUAL( segments, 3 );
+
+	// the voxels are visited in the same order by ++ and in reverse order by --
+	size_t idx = 0;
+
+	for( data::TypedImage<float>::const_iterator i = img.begin(); i != img.end(); ++i, ++idx )
+		BOOST_CHECK_EQUAL( *i, idx / 9 );
+
+	BOOST_CHECK_EQUAL( idx, img.getVolume() );
+
+	for( data::TypedImage<float>::const_iterator i = img.end(); i != img.begin(); )
+		BOOST_CHECK_EQUAL( *( --i ), --idx / 9 );
+
+	BOOST_CHECK_EQUAL( idx, 0 );
+
+	// jumps back and forth across chunks
+	const data::TypedImage<float>::iterator end = img.end();
+	BOOST_CHECK_EQUAL( *( end - 1 ), 2 );
+	BOOST_CHECK_EQUAL( *( end - 10 ), 1 );
+	BOOST_CHECK_EQUAL( *( end - 27 ), 0 );
+	BOOST_CHECK( end - 27 == img.begin() );
+	BOOST_CHECK( ( end - 14 ) + 14 == end );
+	BOOST_CHECK_EQUAL( *( ( end - 14 ) + 8 ), 2 );
+	BOOST_CHECK_EQUAL( ( end - 14 ) - ( img.begin() + 3 ), 10 );
+}
+
+BOOST_AUTO_TEST_CASE ( image_compare_test )
+{
+	std::list<data::Chunk> chunks;
+
+	for( int i = 0; i < 4; i++ )
+		chunks.push_back( genSlice<float>( 4, 4, i, i ) );
+
+	data::TypedImage<float> img = data::Image( chunks );
+	BOOST_REQUIRE( img.isClean() );
+	float cnt = 0;
+
+	for( data::TypedImage<float>::iterator i = img.begin(); i != img.end(); ++i )
+		*i = cnt++;
+
+	// an image made of one volume of another type compares equal
+	data::Image volume( img.copyAsMemChunk<double>() );
+	BOOST_REQUIRE( volume.isClean() );
+	BOOST_CHECK_EQUAL( volume.copyChunksToVector( false ).size(), 1 );
+	BOOST_CHECK_EQUAL( img.compare( volume ), 0 );
+
+	volume.voxel<double>( 1, 2, 3 ) += 0.5;
+	volume.voxel<double>( 3, 3, 3 ) -= 3;
+	const data::CompareResult result = img.compare( volume, data::compare_exact );
+	BOOST_CHECK_EQUAL( result.compared, img.getVolume() );
+	BOOST_CHECK_EQUAL( result.different, 2 );
+	BOOST_CHECK_EQUAL( result.first, 1 + 2 * 4 + 3 * 16 );
+	BOOST_CHECK_EQUAL( result.maxAbsDiff, 3 );
+
+	BOOST_CHECK_EQUAL( img.compare( volume, data::compare_absolute, 1 ).different, 1 );
+	BOOST_CHECK_EQUAL( volume.compare( img, data::compare_absolute, 3 ).different, 0 );
+
+	// the last voxel of a chunk is compared as well
+	const data::Chunk slice = img.getChunk( 0, 0, 3 );
+	data::MemChunk<float> changed( slice );
+	changed.voxel<float>( 3, 3 ) = -1;
+	BOOST_CHECK_EQUAL( slice.compare( changed ), 1 );
+
+	// empty images have nothing to compare
+	std::list<data::Chunk> none;
+	const data::Image empty( none );
+	BOOST_CHECK_EQUAL( empty.compare( empty, data::compare_exact ).compared, 0 );
+	BOOST_CHECK_EQUAL( empty.compare( empty ), 0 );
+}
+
+BOOST_AUTO_TEST_CASE ( image_chunk_view_test )
+{
+	std::list<data::Chunk> chunks;
+
+	for( int i = 0; i < 3; i++ )
+		chunks.push_back( genSlice<float>( 4, 4, i, i ) );
+
+	data::TypedImage<float> img = data::Image( chunks );
+	BOOST_REQUIRE( img.isClean() );
+	float cnt = 0;
+
+	for( data::TypedImage<float>::iterator i = img.begin(); i != img.end(); ++i )
+		*i = ( cnt++ ) / 10;
+
+	// the view is converted the same way as getChunkAs (using the scaling of the whole image)
+	for( size_t z = 0; z < 3; z++ ) {
+		const data::ValueArrayView<short> view = img.getChunkViewAs<short>( 0, 0, z );
+		const data::Chunk converted = img.getChunkAs<short>( 0, 0, z );
+		BOOST_REQUIRE( view.isConverting() );
+		BOOST_REQUIRE_EQUAL( view.getLength(), converted.getVolume() );
+
+		for( size_t i = 0; i < view.getLength(); i++ )
+			BOOST_CHECK_EQUAL( view[i], converted.getValueArray<short>()[i] );
+	}
+
+	// viewing as the own type does not convert
+	BOOST_CHECK( !img.getChunkViewAs<float>( 0, 0, 1 ).isConverting() );
+	BOOST_CHECK_EQUAL( img.getChunkViewAs<float>( 0, 0, 1 )[1], img.voxel<float>( 1, 0, 1 ) );
+}
+
 BOOST_AUTO_TEST_CASE ( image_voxel_value_test )
 {
 	//  get a voxel from inside and outside the image
@@ -86,5 +86,90 @@ BOOST_AUTO_TEST_CASE ( chunklist_sort_test )
 	BOOST_CHECK( chunks.isRectangular() );
 }
 
+BOOST_AUTO_TEST_CASE ( chunklist_geometry_test )
+{
+	data::_internal::SortedChunkList chunks( "rowVec,columnVec,sliceVec,coilChannelMask,sequenceNumber" );
+	chunks.addSecondarySort( "acquisitionNumber" );
+
+	for ( int t = 0; t < 2; t++ ) {
+		for ( int j = 3; j >= 0; j-- ) { // insert backwards, so sorting has to do something
+			data::MemChunk<float> ch( 3, 3 );
+			ch.setPropertyAs( "indexOrigin", util::fvector3( 0, 0, j * 2 ) );
+			ch.setPropertyAs( "acquisitionNumber", t * 4 + j );
+			ch.setPropertyAs( "rowVec", util::fvector3( 1, 0 ) );
+			ch.setPropertyAs( "columnVec", util::fvector3( 0, 1 ) );
+			ch.setPropertyAs( "voxelSize", util::fvector3( 1, 1, 1 ) );
+			BOOST_REQUIRE( chunks.insert( ch ) );
+		}
+	}
+
+	const std::vector<boost::shared_ptr<data::Chunk> > lookup = chunks.getLookup();
+	const std::vector<data::_internal::SortedChunkList::ChunkGeometry> geometry = chunks.getGeometryLookup();
+	BOOST_REQUIRE_EQUAL( geometry.size(), 8 );
+
+	// the cached geometry is in the same order as the lookup and equals the properties of the chunks
+	for ( size_t i = 0; i < lookup.size(); i++ ) {
+		BOOST_CHECK_EQUAL( geometry[i].indexOrigin, lookup[i]->getPropertyAs<util::fvector3>( "indexOrigin" ) );
+		BOOST_CHECK_EQUAL( geometry[i].indexOrigin, util::fvector3( 0, 0, ( i % 4 ) * 2 ) );
+		BOOST_CHECK_EQUAL( geometry[i].rowVec, util::fvector3( 1, 0 ) );
+		BOOST_CHECK_EQUAL( geometry[i].columnVec, util::fvector3( 0, 1 ) );
+		BOOST_CHECK_EQUAL( geometry[i].sliceVec, util::fvector3( 0, 0, 1 ) ); // computed from row- and columnVec
+	}
+
+	// moving the chunks needs an update of the geometry
+	BOOST_FOREACH( const boost::shared_ptr<data::Chunk> &ch, lookup ) {
+		util::fvector3 &origin = ch->propertyValue( "indexOrigin" ).castTo<util::fvector3>();
+		origin[0] += 1;
+	}
+	chunks.updateGeometry();
+
+	for ( size_t i = 0; i < lookup.size(); i++ ) {
+		BOOST_CHECK_EQUAL( chunks.getGeometryLookup()[i].indexOrigin, util::fvector3( 1, 0, ( i % 4 ) * 2 ) );
+	}
+
+	chunks.clear();
+	BOOST_CHECK( chunks.getGeometryLookup().empty() );
+}
+
+BOOST_AUTO_TEST_CASE ( chunklist_hash_test )
+{
+	const data::_internal::SortedChunkList chunks( "rowVec,columnVec,sliceVec,coilChannelMask,sequenceNumber" );
+
+	data::MemChunk<float> ch1( 3, 3 );
+	ch1.setPropertyAs( "indexOrigin", util::fvector3( 0, 0, 0 ) );
+	ch1.setPropertyAs( "acquisitionNumber", 0 );
+	ch1.setPropertyAs( "rowVec", util::fvector3( 1, 0 ) );
+	ch1.setPropertyAs( "columnVec", util::fvector3( 0, 1 ) );
+	ch1.setPropertyAs( "sequenceNumber", ( uint16_t )1 );
+
+	// properties which are not in the equality set don't matter
+	data::MemChunk<float> ch2( ch1 );
+	ch2.setPropertyAs( "indexOrigin", util::fvector3( 0, 0, 1 ) );
+	ch2.setPropertyAs( "acquisitionNumber", 1 );
+	BOOST_CHECK_EQUAL( chunks.getEqualityHash( ch1 ), chunks.getEqualityHash( ch2 ) );
+
+	// -0 is equal to 0
+	ch2.setPropertyAs( "rowVec", util::fvector3( 1, -0.f ) );
+	BOOST_CHECK_EQUAL( chunks.getEqualityHash( ch1 ), chunks.getEqualityHash( ch2 ) );
+
+	// the same number stored as another type is not equal (util::Value::operator== needs the same type), so it doesn't have to get the same hash
+	ch2.remove( "sequenceNumber" );
+	ch2.setPropertyAs( "sequenceNumber", ( int32_t )1 );
+	BOOST_CHECK( ch1.propertyValue( "sequenceNumber" ) != ch2.propertyValue( "sequenceNumber" ) );
+
+	ch2.remove( "sequenceNumber" );
+	ch2.setPropertyAs( "sequenceNumber", ( uint16_t )2 );
+	BOOST_CHECK_NE( chunks.getEqualityHash( ch1 ), chunks.getEqualityHash( ch2 ) );
+
+	ch2.setPropertyAs( "sequenceNumber", ( uint16_t )1 );
+	ch2.setPropertyAs( "coilChannelMask", std::string( "0101" ) );
+	BOOST_CHECK_NE( chunks.getEqualityHash( ch1 ), chunks.getEqualityHash( ch2 ) );
+
+	// chunks of different size never fit together
+	data::MemChunk<float> ch3( 3, 4 );
+	ch3.join( ch1 );
+	BOOST_CHECK_NE( chunks.getEqualityHash( ch1 ), chunks.getEqualityHash( ch3 ) );
+}
+
 }
 }
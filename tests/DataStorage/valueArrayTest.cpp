@@ -9,7 +9,10 @@
 #define BOOST_TEST_MODULE ValueArrayTest
 #include <boost/test/unit_test.hpp>
 #include <DataStorage/valuearray.hpp>
+#include <DataStorage/numeric_convert.hpp>
+#include <DataStorage/valuearray_view.hpp>
 #include <cmath>
+#include <numeric>
 
 
 namespace isis
@@ -224,6 +227,47 @@ BOOST_AUTO_TEST_CASE( ValueArray_conversion_test )
 		BOOST_CHECK_EQUAL( ushortArray[i], ceil( init[i] * 1e5 * uscale + 32767.5 - .5 ) );
 }
 
+BOOST_AUTO_TEST_CASE( ValueArray_saturating_conversion_test )
+{
+	// use more than one vector of values, so the simd-kernels and the remainder loop are both used
+	data::ValueArray<float> floatArray( 67 );
+	data::ValueArray<int32_t> intArray( 67 );
+
+	for ( int i = 0; i < 67; i++ ) {
+		floatArray[i] = ( i - 33 ) * 10.25;
+		intArray[i] = ( i - 33 ) * 1000;
+	}
+
+	floatArray[0] = std::numeric_limits<float>::quiet_NaN();
+	floatArray[1] = std::numeric_limits<float>::infinity();
+	floatArray[2] = -std::numeric_limits<float>::infinity();
+
+	const data::scaling_pair noscale( util::Value<double>( 1 ), util::Value<double>( 0 ) );
+	data::ValueArray<uint8_t> byteArray = floatArray.copyAs<uint8_t>( noscale );
+	data::ValueArray<int8_t> sbyteArray = intArray.copyAs<int8_t>( noscale );
+	data::ValueArray<int16_t> shortArray = floatArray.copyAs<int16_t>( data::scaling_pair( util::Value<double>( 100 ), util::Value<double>( 0.5 ) ) );
+
+	BOOST_CHECK_EQUAL( byteArray[0], 0 ); // NaN
+	BOOST_CHECK_EQUAL( byteArray[1], 255 ); // inf
+	BOOST_CHECK_EQUAL( byteArray[2], 0 ); // -inf
+
+	for ( int i = 3; i < 67; i++ ) {
+		const double fval = ( i - 33 ) * 10.25, sval = fval * 100 + 0.5;
+		BOOST_CHECK_EQUAL( byteArray[i], fval < 0 ? 0 : ( fval > 255 ? 255 : floor( fval + .5 ) ) );
+		BOOST_CHECK_EQUAL( shortArray[i], std::max<double>( std::min<double>( sval < 0 ? ceil( sval - .5 ) : floor( sval + .5 ), 32767 ), -32768 ) ); // round half away from zero
+	}
+
+	for ( int i = 0; i < 67; i++ )
+		BOOST_CHECK_EQUAL( sbyteArray[i], std::max( std::min( ( i - 33 ) * 1000, 127 ), -128 ) );
+
+	// numeric_convert is public, so its kernels must be usable from outside the library as well
+	std::vector<int8_t> direct( 67 );
+	data::numeric_convert( &intArray[0], &direct[0], 67, 1, 0 );
+
+	for ( int i = 0; i < 67; i++ )
+		BOOST_CHECK_EQUAL( direct[i], sbyteArray[i] );
+}
+
 BOOST_AUTO_TEST_CASE( ValueArray_complex_minmax_test )
 {
 	const std::complex<float> init[] = { std::complex<float>( -2, 1 ), -1.8, -1.5, -1.3, -0.6, -0.2, 2, 1.8, 1.5, 1.3, 0.6, std::complex<float>( 0.2, -5 )};
@@ -403,6 +447,127 @@ BOOST_AUTO_TEST_CASE( ValueArray_rnd_minmax_test )
 }
 
 
+template<typename T> void minMaxVectorized( size_t len )
+{
+	data::ValueArray<T> array( len );
+
+	for( size_t i = 0; i < len; i++ )
+		array[i] = ( static_cast<T>( rand() ) - RAND_MAX / 2 ) / 7;
+
+	// non-finite values at the start, inside the vectorized part and in the tail must be ignored
+	const size_t bad[] = {0, 5, len / 2, len - 2, len - 1};
+
+	for( size_t i = 0; i < sizeof( bad ) / sizeof( size_t ); i++ ) {
+		const T val = i % 3 == 0 ? std::numeric_limits<T>::quiet_NaN() : ( i % 3 == 1 ? std::numeric_limits<T>::infinity() : -std::numeric_limits<T>::infinity() );
+		array[bad[i]] = val;
+	}
+
+	std::pair<T, T> expect( std::numeric_limits<T>::max(), -std::numeric_limits<T>::max() );
+
+	for( size_t i = 0; i < len; i++ ) {
+		if( array[i] == array[i] && array[i] - array[i] == 0 ) {
+			expect.first = std::min( expect.first, array[i] );
+			expect.second = std::max( expect.second, array[i] );
+		}
+	}
+
+	const std::pair<util::ValueReference, util::ValueReference> minmax = array.getMinMax();
+	BOOST_CHECK_EQUAL( minmax.first->as<T>(), expect.first );
+	BOOST_CHECK_EQUAL( minmax.second->as<T>(), expect.second );
+}
+
+template<typename T> void minMax64( size_t len )
+{
+	data::ValueArray<T> array( len );
+
+	for( size_t i = 0; i < len; i++ )
+		array[i] = ( static_cast<T>( rand() ) << 32 ) ^ rand();
+
+	// put the extremes into the tail and the vectorized part
+	array[len - 1] = std::numeric_limits<T>::max();
+	array[len / 2] = std::numeric_limits<T>::min();
+
+	const std::pair<util::ValueReference, util::ValueReference> minmax = array.getMinMax();
+	BOOST_CHECK_EQUAL( minmax.first->as<T>(), std::numeric_limits<T>::min() );
+	BOOST_CHECK_EQUAL( minmax.second->as<T>(), std::numeric_limits<T>::max() );
+}
+
+BOOST_AUTO_TEST_CASE( ValueArray_vectorized_minmax_test )
+{
+	const size_t lengths[] = {7, 67, 1027, 1000003}; // the biggest is split into blocks if there are threads
+
+	for( size_t i = 0; i < sizeof( lengths ) / sizeof( size_t ); i++ ) {
+		minMaxVectorized<float>( lengths[i] );
+		minMaxVectorized<double>( lengths[i] );
+		minMax64<int64_t>( lengths[i] );
+		minMax64<uint64_t>( lengths[i] );
+	}
+
+	// if there is no finite value at all, the result is the same as from the generic implementation
+	data::ValueArray<double> invalid( 33 );
+
+	for( size_t i = 0; i < invalid.getLength(); i++ )
+		invalid[i] = i % 2 ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+
+	const std::pair<util::ValueReference, util::ValueReference> minmax = invalid.getMinMax();
+	BOOST_CHECK_EQUAL( minmax.first->as<double>(), std::numeric_limits<double>::max() );
+	BOOST_CHECK_EQUAL( minmax.second->as<double>(), -std::numeric_limits<double>::max() );
+}
+
+BOOST_AUTO_TEST_CASE( ValueArray_cached_minmax_test )
+{
+	data::ValueArray<int16_t> array( 100 );
+	const data::ValueArray<int16_t> &const_array = array;
+	array[10] = -5;
+	array[20] = 5;
+	BOOST_CHECK_EQUAL( const_array.getMinMax().first->as<int16_t>(), -5 );
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 5 );
+
+	// all kinds of writing access must invalidate the cached min/max
+	array[30] = 6;
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 6 );
+
+	*( array.begin() + 31 ) = 7;
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 7 );
+
+	const int16_t mem[] = {-8, 8};
+	array.copyFromMem( mem, 2 );
+	BOOST_CHECK_EQUAL( const_array.getMinMax().first->as<int16_t>(), -8 );
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 8 );
+
+	boost::static_pointer_cast<int16_t>( array.getRawAddress() ).get()[40] = 9;
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 9 );
+
+	*( array.beginGeneric() + 41 ) = util::Value<int16_t>( 10 );
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 10 );
+
+	// copies share the cache
+	data::ValueArray<int16_t> copy = array;
+	copy[50] = 11;
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 11 );
+
+	// writing into a splice invalidates the original, and the other way around
+	const std::vector<data::ValueArrayReference> splices = array.splice( 50 );
+	BOOST_CHECK_EQUAL( splices[1]->getMinMax().second->as<int16_t>(), 11 );
+	splices[1]->castToValueArray<int16_t>()[1] = 12;
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 12 );
+	array[52] = 13;
+	BOOST_CHECK_EQUAL( splices[1]->getMinMax().second->as<int16_t>(), 13 );
+
+	// writes through pointers got before the min/max was computed are seen as well
+	int16_t *const ptr = &array[0];
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 13 );
+	ptr[60] = 14;
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 14 );
+
+	// once the writing is finished the min/max is cached again, and the next writing access drops it
+	array.invalidateStats();
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 14 );
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 14 );
+	array[61] = 15;
+	BOOST_CHECK_EQUAL( const_array.getMinMax().second->as<int16_t>(), 15 );
+}
+
 BOOST_AUTO_TEST_CASE( ValueArray_iterator_test )
 {
 	data::ValueArray<short> array( 1024 );
@@ -450,5 +615,196 @@ BOOST_AUTO_TEST_CASE( ValueArray_generic_iterator_test )
 
 	BOOST_CHECK_EQUAL( std::distance( array.begin(), array.end() ), 1024 );
 }
+
+struct SumOp {
+	double sum;
+	template<typename T> void operator()( const data::ValueArray<T> &array ) {
+		sum = std::accumulate( array.begin(), array.end(), 0. );
+	}
+};
+BOOST_AUTO_TEST_CASE( ValueArray_visit_test )
+{
+	data::ValueArray<short> array( 1024 );
+
+	for( int i = 0; i < 1024; i++ )
+		array[i] = i + 1;
+
+	SumOp op = {0};
+	BOOST_REQUIRE( data::visit( static_cast<const data::ValueArrayBase &>( array ), op ) );
+	BOOST_CHECK_EQUAL( op.sum, 1024 * ( 1024 + 1 ) / 2 );
+
+	// there is no visit for non numbers
+	data::ValueArray<util::color24> colors( 4 );
+	BOOST_CHECK( !data::visit( static_cast<const data::ValueArrayBase &>( colors ), op ) );
+}
+BOOST_AUTO_TEST_CASE( ValueArray_get_set_values_test )
+{
+	data::ValueArray<short> array( 1024 );
+	data::ValueArrayBase &generic_array = array;
+	std::vector<double> buff( 1024 );
+
+	for( int i = 0; i < 1024; i++ )
+		buff[i] = i - 512.4;
+
+	// values are rounded, and saturated if they don't fit
+	buff[0] = 1e6;
+	BOOST_REQUIRE( generic_array.setValues( &buff[0], 0, 1024 ) );
+	BOOST_CHECK_EQUAL( array[0], std::numeric_limits<short>::max() );
+
+	for( int i = 1; i < 1024; i++ )
+		BOOST_CHECK_EQUAL( array[i], i - 512 );
+
+	// reading a part of it
+	std::vector<int64_t> values( 10 );
+	BOOST_REQUIRE( generic_array.getValues( &values[0], 100, 10 ) );
+
+	for( int i = 0; i < 10; i++ )
+		BOOST_CHECK_EQUAL( values[i], i + 100 - 512 );
+
+	// writing invalidates the cached minmax
+	BOOST_CHECK_EQUAL( array.getMinMax().second->as<short>(), std::numeric_limits<short>::max() );
+	const float one = 1;
+	BOOST_REQUIRE( generic_array.setValues( &one, 0, 1 ) );
+	BOOST_CHECK_EQUAL( array.getMinMax().second->as<short>(), 1023 - 512 );
+
+	// ranges behind the end are refused
+	BOOST_CHECK( !generic_array.getValues( &values[0], 1020, 10 ) );
+}
+BOOST_AUTO_TEST_CASE( ValueArray_compare_test )
+{
+	const size_t size = 100000; // big enough to be split into blocks
+	data::ValueArray<float> a( size ), b( size );
+
+	for( size_t i = 0; i < size; i++ )
+		a[i] = b[i] = i;
+
+	BOOST_CHECK_EQUAL( a.compare( 0, size, b, 0 ), 0 );
+
+	b[70000] += 0.5;
+	b[90000] -= 2;
+	a[80000] = b[80000] = std::numeric_limits<float>::quiet_NaN(); // NaN equals NaN
+
+	data::CompareResult result = a.compare( 0, size, b, 0, data::compare_exact );
+	BOOST_CHECK_EQUAL( result.compared, size );
+	BOOST_CHECK_EQUAL( result.different, 2 );
+	BOOST_CHECK_EQUAL( result.first, 70000 );
+	BOOST_CHECK_EQUAL( result.maxAbsDiff, 2 );
+	BOOST_CHECK_CLOSE( result.rms(), std::sqrt( ( 0.25 + 4 ) / size ), 1e-4 );
+
+	// the old interface counts the differences
+	BOOST_CHECK_EQUAL( a.compare( 0, size, b, 0 ), 2 );
+
+	// the tolerance
+	BOOST_CHECK_EQUAL( a.compare( 0, size, b, 0, data::compare_absolute, 1 ).different, 1 );
+	BOOST_CHECK_EQUAL( a.compare( 0, size, b, 0, data::compare_absolute, 2 ).different, 0 );
+	BOOST_CHECK_EQUAL( a.compare( 0, size, b, 0, data::compare_relative, 1e-5 ).different, 1 ); // 0.5/70000.5 is less, 2/90000 is more
+	BOOST_CHECK_EQUAL( a.compare( 0, size, b, 0, data::compare_relative, 1e-4 ).different, 0 );
+
+	// stopping at the first difference
+	result = a.compare( 0, size, b, 0, data::compare_exact, 0, true );
+	BOOST_CHECK_EQUAL( result.first, 70000 );
+	BOOST_CHECK_GE( result.different, 1 );
+
+	// comparing parts with an offset
+	result = a.compare( 75000, size, b, 75000, data::compare_exact );
+	BOOST_CHECK_EQUAL( result.different, 1 );
+	BOOST_CHECK_EQUAL( result.first, 90000 - 75000 );
+
+	// a NaN on one side only is a difference
+	b[80000] = 1;
+	BOOST_CHECK_EQUAL( a.compare( 0, size, b, 0, data::compare_absolute, 1e9 ).different, 1 );
+
+	// values of different types are compared by their value
+	data::ValueArray<short> c( 1000 );
+	data::ValueArray<double> d( 1000 );
+
+	for( size_t i = 0; i < 1000; i++ )
+		c[i] = d[i] = i;
+
+	d[500] = 500.25;
+	result = c.compare( 0, 1000, d, 0, data::compare_exact );
+	BOOST_CHECK_EQUAL( result.different, 1 );
+	BOOST_CHECK_EQUAL( result.first, 500 );
+	BOOST_CHECK_EQUAL( result.maxAbsDiff, 0.25 );
+	BOOST_CHECK_EQUAL( c.compare( 0, 1000, d, 0, data::compare_absolute, 0.5 ).different, 0 );
+	BOOST_CHECK_EQUAL( c.compare( 0, 1000, d, 0 ), 1 ); // the old interface does the same
+
+	// non numbers can't be compared to numbers
+	data::ValueArray<util::color24> colors( 1000 );
+	BOOST_CHECK_EQUAL( colors.compare( 0, 1000, c, 0, data::compare_exact ).different, 1000 );
+}
+
+struct BlockSum {
+	double sum;
+	size_t elements;
+	void operator()( const float *block, size_t /*start*/, size_t count ) {
+		sum = std::accumulate( block, block + count, sum );
+		elements += count;
+	}
+};
+BOOST_AUTO_TEST_CASE( ValueArray_view_test )
+{
+	const size_t size = 10000;
+	data::ValueArray<short> array( size );
+
+	for( size_t i = 0; i < size; i++ )
+		array[i] = i - 5000;
+
+	// view as another type converts tile by tile
+	const data::ValueArrayView<float> view( array, data::scaling_pair(), 1000 );
+	BOOST_REQUIRE( view.isConverting() );
+	BOOST_CHECK_EQUAL( view.getLength(), size );
+
+	for( size_t i = 0; i < size; i += 7 ) // forwards
+		BOOST_CHECK_EQUAL( view[i], i - 5000. );
+
+	for( size_t i = size; i > 13; i -= 13 ) // and backwards
+		BOOST_CHECK_EQUAL( view[i - 1], i - 5001. );
+
+	const float *block = view.getBlock( 2500, 1000 ); // blocks don't have to fit the tiles
+	BOOST_CHECK_EQUAL( block[0], -2500 );
+	BOOST_CHECK_EQUAL( block[999], -1501 );
+
+	BlockSum sum = {0, 0};
+	view.forEachBlock( sum );
+	BOOST_CHECK_EQUAL( sum.elements, size );
+	BOOST_CHECK_EQUAL( sum.sum, -5000. * size + size * ( size - 1 ) / 2 );
+
+	// scaling is applied, integers are rounded and saturated
+	const data::scaling_pair scaling( util::ValueReference( util::Value<double>( 0.5 ) ), util::ValueReference( util::Value<double>( 1 ) ) );
+	const data::ValueArrayView<int8_t> scaled( array, scaling );
+	BOOST_CHECK_EQUAL( scaled[5000], 1 );
+	BOOST_CHECK_EQUAL( scaled[5004], 3 );
+	BOOST_CHECK_EQUAL( scaled[0], std::numeric_limits<int8_t>::min() );
+	BOOST_CHECK_EQUAL( scaled[size - 1], std::numeric_limits<int8_t>::max() );
+
+	std::vector<int8_t> copy( 10 );
+	BOOST_REQUIRE( scaled.copyToMem( &copy[0], 4990, 10 ) );
+
+	for( int i = 0; i < 10; i++ )
+		BOOST_CHECK_EQUAL( copy[i], data::_internal::round<int8_t>( ( i - 10 ) * 0.5 + 1 ) );
+
+	// view as the own type reads directly, so changes are visible at once
+	const data::ValueArrayView<short> direct( array, data::scaling_pair() );
+	BOOST_CHECK( !direct.isConverting() );
+	array[10] = 42;
+	BOOST_CHECK_EQUAL( direct[10], 42 );
+	BOOST_CHECK_EQUAL( direct.getBlock( 10, 1 ), &array[10] );
+
+	// converting views see changes only after reset
+	data::ValueArrayView<float> converted( array, data::scaling_pair() );
+	BOOST_CHECK_EQUAL( converted[11], 11 - 5000 );
+	array[11] = 42;
+	BOOST_CHECK_EQUAL( converted[11], 11 - 5000 );
+	converted.reset();
+	BOOST_CHECK_EQUAL( converted[11], 42 );
+
+	// non numbers are converted as a whole
+	data::ValueArray<util::color24> colors( 4 );
+	colors[2].g = 100;
+	const data::ValueArrayView<util::color48> colorView( colors, data::scaling_pair() );
+	BOOST_CHECK( !colorView.isConverting() );
+	BOOST_CHECK_EQUAL( colorView[2].g, 100 );
+}
 }
 }
@@ -9,6 +9,7 @@
 #include <DataStorage/io_factory.hpp>
 #include <CoreUtils/log.hpp>
 #include <CoreUtils/tmpfile.hpp>
+#include <DataStorage/fileptr.hpp>
 
 using namespace isis;
 
@@ -150,6 +151,69 @@ BOOST_AUTO_TEST_CASE( loadsaveSFormImage )
 
 }
 
+BOOST_AUTO_TEST_CASE( loadFromMemory )
+{
+	data::MemChunk<short> ch( 64, 32, 3 );
+	ch.setPropertyAs( "indexOrigin", util::fvector3( 0, 0, 0 ) );
+	ch.setPropertyAs( "rowVec", util::fvector3( 1, 0 ) );
+	ch.setPropertyAs( "columnVec", util::fvector3( 0, 1 ) );
+	ch.setPropertyAs( "voxelSize", util::fvector3( 1, 1, 1 ) );
+	ch.setPropertyAs( "acquisitionNumber", ( uint32_t )0 );
+	ch.setPropertyAs( "sequenceNumber", ( uint16_t )0 );
+
+	for( size_t i = 0; i < ch.getVolume(); i++ )
+		ch.asValueArray<short>()[i] = i % 1000;
+
+	const data::Image img( ch );
+	util::TmpFile niifile( "", ".nii" );
+	BOOST_REQUIRE( data::IOFactory::write( img, niifile.native() ) );
+
+	// copy the file into memory and load it from there
+	const data::FilePtr file( niifile );
+	data::ValueArray<uint8_t> mem( file.getLength() );
+	file.copyToMem( &mem[0], mem.getLength() );
+
+	std::list<data::Chunk> chunks;
+	BOOST_REQUIRE_EQUAL( data::IOFactory::load( chunks, mem, "memory.nii" ), 1 );
+	BOOST_CHECK_EQUAL( chunks.front().getPropertyAs<std::string>( "source" ), "memory.nii" );
+
+	const std::list<data::Image> images = data::IOFactory::chunkListToImageList( chunks );
+	BOOST_REQUIRE_EQUAL( images.size(), 1 );
+	BOOST_CHECK_EQUAL( images.front().getSizeAsVector(), img.getSizeAsVector() );
+	BOOST_CHECK_EQUAL( images.front().compare( img ), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( loadsaveCompressed )
+{
+	data::MemChunk<int32_t> ch( 128, 128, 16 ); // big enough for several gzip members
+	ch.setPropertyAs( "indexOrigin", util::fvector3( 0, 0, 0 ) );
+	ch.setPropertyAs( "rowVec", util::fvector3( 1, 0 ) );
+	ch.setPropertyAs( "columnVec", util::fvector3( 0, 1 ) );
+	ch.setPropertyAs( "voxelSize", util::fvector3( 1, 1, 1 ) );
+	ch.setPropertyAs( "acquisitionNumber", ( uint32_t )0 );
+	ch.setPropertyAs( "sequenceNumber", ( uint16_t )0 );
+
+	for( size_t i = 0; i < ch.getVolume(); i++ )
+		ch.asValueArray<int32_t>()[i] = ( i * 7919 ) % 100003;
+
+	const data::Image img( ch );
+	util::TmpFile gzfile( "", ".nii.gz" );
+	BOOST_REQUIRE( data::IOFactory::write( img, gzfile.native() ) );
+
+	// it has to be a valid gzip file (the members are BGZF, which is gzip with the size of the member in an extra field)
+	const data::FilePtr file( gzfile );
+	BOOST_REQUIRE( file.getLength() > 18 );
+	BOOST_CHECK_EQUAL( file[0], 31 );
+	BOOST_CHECK_EQUAL( file[1], 139 );
+	BOOST_CHECK_EQUAL( file[12], 'B' );
+	BOOST_CHECK_EQUAL( file[13], 'C' );
+
+	const std::list<data::Image> images = data::IOFactory::load( gzfile.native() );
+	BOOST_REQUIRE_EQUAL( images.size(), 1 );
+	BOOST_CHECK_EQUAL( images.front().getSizeAsVector(), img.getSizeAsVector() );
+	BOOST_CHECK_EQUAL( images.front().compare( img ), 0 );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
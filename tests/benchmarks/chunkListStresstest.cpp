@@ -0,0 +1,32 @@
+#include "DataStorage/io_factory.hpp"
+#include <boost/timer.hpp>
+
+using namespace isis;
+
+const uint16_t series = 200;
+const size_t slices = 200;
+
+int main()
+{
+	boost::timer timer;
+	std::list<data::Chunk> chunks;
+
+	// the slices of all series are mixed, like they would be when loading a directory of dicom files
+	for ( size_t slice = 0; slice < slices; slice++ ) {
+		for ( uint16_t s = 0; s < series; s++ ) {
+			chunks.push_back( data::MemChunk<short>( 8, 8 ) );
+			chunks.back().setPropertyAs( "rowVec", util::fvector3( 1, 0 ) );
+			chunks.back().setPropertyAs( "columnVec", util::fvector3( 0, 1 ) );
+			chunks.back().setPropertyAs( "indexOrigin", util::fvector3( 0, 0, slice ) );
+			chunks.back().setPropertyAs( "acquisitionNumber", ( uint32_t )slice );
+			chunks.back().setPropertyAs( "voxelSize", util::fvector3( 1, 1, 1 ) );
+			chunks.back().setPropertyAs( "sequenceNumber", s );
+		}
+	}
+
+	std::cout << series << "*" << slices << " Chunks created in " << timer.elapsed() << " sec " << std::endl;
+	timer.restart();
+	const std::list<data::Image> images = data::IOFactory::chunkListToImageList( chunks );
+	std::cout << images.size() << " images of " << images.front().getSizeAsString() << " assembled in " << timer.elapsed() << " sec" << std::endl;
+	return 0;
+}
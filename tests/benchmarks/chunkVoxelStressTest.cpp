@@ -5,6 +5,18 @@ using namespace isis;
 
 const size_t chunk_size = 120;
 
+template<typename TYPE> struct SetTo {
+	TYPE value;
+	bool operator()( TYPE &vox, const util::vector4<size_t> & ) {vox = value; return true;}
+};
+template<typename TYPE> class VirtualSetTo: public data::VoxelOp<TYPE>
+{
+	TYPE value;
+public:
+	bool operator()( TYPE &vox, const util::vector4<size_t> & ) {vox = value; return true;}
+	VirtualSetTo( const TYPE &_value ): value( _value ) {}
+};
+
 template<typename TYPE>
 void check( const data::Chunk &chunk, const TYPE &value )
 {
@@ -99,5 +111,17 @@ int main()
 	std::cout << "Needed " << timer.elapsed() << " seconds to iterator with own \"getLinearIndex\" function." << std::endl;
 	check<TYPE>( big_chunk, 4 );
 
+	timer.restart();
+	VirtualSetTo<TYPE> set5( 5 );
+	big_chunk.foreachVoxel( set5 );
+	std::cout << "Needed " << timer.elapsed() << " seconds with Chunk::foreachVoxel (virtual VoxelOp)." << std::endl;
+	check<TYPE>( big_chunk, 5 );
+
+	timer.restart();
+	SetTo<TYPE> set6 = {6};
+	data::forEachVoxel<TYPE>( big_chunk, set6 );
+	std::cout << "Needed " << timer.elapsed() << " seconds with data::forEachVoxel (inlined functor)." << std::endl;
+	check<TYPE>( big_chunk, 6 );
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "DataStorage/image.hpp"
+#include "CoreUtils/threadpool.hpp"
+#include <boost/lexical_cast.hpp>
+#include "walltimer.hpp"
+
+using namespace isis;
+
+const size_t slices = 100;
+const size_t timesteps = 100;
+const size_t dicomProps = 200;
+
+int main()
+{
+	test::WallTimer timer;
+	std::vector<data::Chunk> chunks;
+	chunks.reserve( slices * timesteps );
+
+	// every slice gets a DICOM-like tree of properties, most of which are the same for all slices
+	for ( size_t t = 0; t < timesteps; t++ ) {
+		for ( size_t slice = 0; slice < slices; slice++ ) {
+			data::MemChunk<short> ch( 64, 64 );
+			ch.setPropertyAs( "rowVec", util::fvector3( 1, 0 ) );
+			ch.setPropertyAs( "columnVec", util::fvector3( 0, 1 ) );
+			ch.setPropertyAs( "indexOrigin", util::fvector3( 0, 0, slice ) );
+			ch.setPropertyAs( "acquisitionNumber", ( uint32_t )( t * slices + slice ) );
+			ch.setPropertyAs( "acquisitionTime", t * 2000. + slice * 20 );
+			ch.setPropertyAs( "voxelSize", util::fvector3( 1, 1, 1 ) );
+			ch.setPropertyAs( "sequenceNumber", ( uint16_t )1 );
+
+			for( size_t p = 0; p < dicomProps; p++ ) {
+				const std::string name = "DICOM/Prop" + boost::lexical_cast<std::string>( p );
+				ch.setPropertyAs( name.c_str(), p % 20 ? ( int32_t )p : ( int32_t )slice );
+			}
+
+			chunks.push_back( ch );
+		}
+	}
+
+	std::cout << slices << "*" << timesteps << " Chunks created in " << timer.elapsed() << " sec " << std::endl;
+
+	timer.restart();
+	const data::Image img( chunks ); // most of this is spent in deduplicateProperties
+	std::cout << "Image of " << img.getSizeAsString() << " assembled and deduplicated by "
+			  << util::ThreadPool::global().getConcurrency() << " threads in "
+			  << timer.elapsed() << " sec" << std::endl;
+	return 0;
+}
@@ -0,0 +1,49 @@
+#include "DataStorage/fileptr.hpp"
+#include "CoreUtils/tmpfile.hpp"
+#include "walltimer.hpp"
+#include <boost/lexical_cast.hpp>
+#include <numeric>
+
+using namespace isis;
+
+// reads a file with all read modes of FilePtr and sums up its content
+// usage: fileReadStresstest [file] (a temporary file of 256MB is used if no file is given)
+// run it on the storage you want to test (drop the page cache between runs to measure cold reads)
+int main( int argc, char *argv[] )
+{
+	boost::shared_ptr<util::TmpFile> tmpfile;
+	boost::filesystem::path filename;
+
+	if( argc > 1 ) {
+		filename = argv[1];
+	} else {
+		tmpfile.reset( new util::TmpFile );
+		filename = *tmpfile;
+		const size_t size = 256 * 1024 * 1024;
+		data::FilePtr out( filename, size, true );
+
+		for( size_t i = 0; i < size; i++ )
+			out[i] = i % 251;
+	}
+
+	const char *names[] = {"", "mmap", "pread", "direct"};
+
+	for( int m = data::FilePtr::read_mmap; m <= data::FilePtr::read_direct; m++ ) {
+		const test::WallTimer timer;
+		data::FilePtr in( filename, 0, false, data::FilePtr::access_sequential, static_cast<data::FilePtr::readMode>( m ) );
+
+		if( !in.good() ) {
+			std::cerr << "Failed to open " << filename << std::endl;
+			return 1;
+		}
+
+		const size_t sum = std::accumulate( in.begin(), in.end(), size_t( 0 ) );
+		const double elapsed = timer.elapsed();
+
+		std::cout
+				<< names[m] << ": " << in.getLength() / ( 1024. * 1024 ) << "MB read and summed up in "
+				<< elapsed << " sec (sum " << sum << ")" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,56 @@
+#include "CoreUtils/log.hpp"
+#include "CoreUtils/common.hpp"
+#include "walltimer.hpp"
+
+using namespace isis;
+
+// streaming this is not for free, so it would show up if the arguments of disabled messages were evaluated
+struct Expensive {
+	size_t i;
+};
+std::ostream &operator<<( std::ostream &o, const Expensive &e )
+{
+	return o << boost::lexical_cast<std::string>( e.i * 0.5 );
+}
+
+int main()
+{
+	const size_t calls = 10000000;
+	test::WallTimer timer;
+
+	util::enableLog<util::DefaultMsgPrint>( notice ); // so verbose_info is disabled
+
+	timer.restart();
+
+	for( size_t i = 0; i < calls; i++ ) {
+		const Expensive e = {i};
+		LOG( util::Debug, verbose_info ) << "Disabled message number " << i << " " << e << " " << util::MSubject( "subject" );
+	}
+
+	const double disabled = timer.elapsed();
+	std::cout << disabled << " sec for " << calls << " disabled LOG calls (" << disabled / calls * 1e9 << " ns per call)" << std::endl;
+
+	timer.restart();
+
+	for( size_t i = 0; i < calls; i++ ) {
+		const Expensive e = {i};
+		LOG_IF( i % 2, util::Debug, verbose_info ) << "Disabled message number " << i << " " << e << " " << util::MSubject( "subject" );
+	}
+
+	const double disabled_if = timer.elapsed();
+	std::cout << disabled_if << " sec for " << calls << " disabled LOG_IF calls (" << disabled_if / calls * 1e9 << " ns per call)" << std::endl;
+
+	// what every disabled call used to cost: create the message, stream into it and drop it in its destructor
+	const size_t old_calls = calls / 10;
+	timer.restart();
+
+	for( size_t i = 0; i < old_calls; i++ ) {
+		const Expensive e = {i};
+		util::_internal::Log<util::Debug>::send( __FILE__, __FUNCTION__, __LINE__, verbose_info )
+				<< "Disabled message number " << i << " " << e << " " << util::MSubject( "subject" );
+	}
+
+	const double created = timer.elapsed();
+	std::cout << created << " sec for " << old_calls << " created and dropped messages (" << created / old_calls * 1e9 << " ns per call)" << std::endl;
+	return 0;
+}
@@ -10,6 +10,7 @@ template<typename T> data::MemChunk<T> makeChunk( size_t size, short slice )
 	ret.setPropertyAs( "columnVec", util::fvector3( 0, 1 ) );
 	ret.setPropertyAs( "indexOrigin", util::fvector3( 0, 0, slice ) );
 	ret.setPropertyAs( "voxelSize", util::fvector3( 1, 1, 1 ) );
+	ret.setPropertyAs( "sequenceNumber", ( uint16_t )1 );
 	return ret;
 }
 
@@ -51,6 +52,31 @@ int main()
 		}
 
 		std::cout << img.getVolume() << " voxel values red in " << timer.elapsed() << " sec" << std::endl;
+		timer.restart();
+
+		// process whole chunks at once
+		for( data::TypedImage<short>::iterator i = img.begin(); i != img.end(); i.nextSegment() )
+			std::fill( i.local(), i.localEnd(), 23 );
+
+		std::cout << img.getVolume() << " voxel set to 23 chunk by chunk in " << timer.elapsed() << " sec" << std::endl;
+		timer.restart();
+
+		const data::TypedImage<short> &cimg = img;
+		std::cout << std::count( cimg.begin(), cimg.end(), 23 ) << " voxel counted in " << timer.elapsed() << " sec" << std::endl;
+	}
+	{
+		std::cout << "===============Testing MemChunk===============" << std::endl;
+		data::MemChunk<short> ch( 256, 256, 256 );
+		timer.restart();
+
+		BOOST_FOREACH( short & ref, ch.asValueArray<short>() ) {
+			ref = 42;
+		}
+
+		std::cout << ch.getVolume() << " voxel set to 42 in " << timer.elapsed() << " sec" << std::endl;
+		timer.restart();
+		const data::ValueArray<short> &array = ch.asValueArray<short>();
+		std::cout << std::count( array.begin(), array.end(), 42 ) << " voxel counted in " << timer.elapsed() << " sec" << std::endl;
 	}
 	return 0;
 }
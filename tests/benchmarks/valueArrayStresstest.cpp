@@ -1,11 +1,12 @@
 #include "DataStorage/valuearray.hpp"
-#include <boost/timer.hpp>
+#include "DataStorage/numeric_convert.hpp"
+#include "walltimer.hpp"
 
 using namespace isis;
 
 template<typename T> void testMinMax( size_t size )
 {
-	boost::timer timer;
+	test::WallTimer timer;
 	data::ValueArray<T> array( ( T * )malloc( size ), size / sizeof( T ) );
 
 	timer.restart();
@@ -15,6 +16,18 @@ template<typename T> void testMinMax( size_t size )
 			<< " in " << timer.elapsed() << " seconds " << std::endl;
 
 }
+template<typename SRC, typename DST> void testConvert( size_t size )
+{
+	test::WallTimer timer;
+	data::ValueArray<SRC> array( size / sizeof( SRC ) );
+	const data::scaling_pair scale = array.getScalingTo( data::ValueArray<DST>::staticID, data::upscale );
+
+	timer.restart();
+	array.template copyAs<DST>( scale );
+	std::cout
+			<< "converted " << size / 1024 / 1024 << "MB of " << data::ValueArray<SRC>::staticName() << " to " << data::ValueArray<DST>::staticName()
+			<< " in " << timer.elapsed() << " seconds (using " << data::getSimdName( data::getSimdLevel() ) << ")" << std::endl;
+}
 int main()
 {
 	data::enableLog<util::DefaultMsgPrint>( verbose_info ); //set to "verbose_info" to see which alg is used
@@ -22,12 +35,18 @@ int main()
 	testMinMax< int8_t>( 1024 * 1024 * 512 );
 	testMinMax<int16_t>( 1024 * 1024 * 512 );
 	testMinMax<int32_t>( 1024 * 1024 * 512 );
+	testMinMax<int64_t>( 1024 * 1024 * 512 );
 
 	testMinMax< uint8_t>( 1024 * 1024 * 512 );
 	testMinMax<uint16_t>( 1024 * 1024 * 512 );
 	testMinMax<uint32_t>( 1024 * 1024 * 512 );
+	testMinMax<uint64_t>( 1024 * 1024 * 512 );
 
 	testMinMax< float>( 1024 * 1024 * 512 );
 	testMinMax<double>( 1024 * 1024 * 512 );
+
+	testConvert<int16_t, float>( 1024 * 1024 * 512 );
+	testConvert<float, uint8_t>( 1024 * 1024 * 512 );
+	testConvert<double, int16_t>( 1024 * 1024 * 512 );
 	return 0;
 }
@@ -38,6 +38,20 @@ int main()
 		}
 
 		std::cout << ch.getVolume() << " voxel values red in " << timer.elapsed() << " sec" << std::endl;
+
+		// the same without knowing the type, but in bulk
+		std::vector<double> buff( ch.getVolume(), 23 );
+		timer.restart();
+		ch.asValueArrayBase().setValues( &buff[0], 0, buff.size() );
+		std::cout << ch.getVolume() << " voxel set to 23 by setValues in " << timer.elapsed() << " sec" << std::endl;
+
+		timer.restart();
+		ch.getValueArrayBase().getValues( &buff[0], 0, buff.size() );
+
+		if( std::count( buff.begin(), buff.end(), 23 ) != ( int )buff.size() )
+			std::cout << "Whoops, something is very wrong ..." << std::endl;
+
+		std::cout << ch.getVolume() << " voxel values red by getValues in " << timer.elapsed() << " sec" << std::endl;
 	}
 	{
 		std::cout << "===============Testing Image==================" << std::endl;
@@ -0,0 +1,23 @@
+#ifndef WALLTIMER_HPP
+#define WALLTIMER_HPP
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace isis
+{
+namespace test
+{
+/// Measures the elapsed wall clock time (boost::timer measures the cpu time, which adds up the time of all threads and leaves out waiting).
+class WallTimer
+{
+	boost::posix_time::ptime m_start;
+public:
+	WallTimer(): m_start( boost::posix_time::microsec_clock::universal_time() ) {}
+	void restart() {m_start = boost::posix_time::microsec_clock::universal_time();}
+	/// \returns the seconds since the construction or the last restart
+	double elapsed()const {return ( boost::posix_time::microsec_clock::universal_time() - m_start ).total_microseconds() / 1e6;}
+};
+}
+}
+
+#endif // WALLTIMER_HPP
@@ -86,7 +86,7 @@ std::list<data::Image> findFitting( const data::Image reference, std::list<data:
 	return images;
 }
 
-bool diff( const data::Image &img1, const data::Image &img2, const util::slist &ignore )
+bool diff( const data::Image &img1, const data::Image &img2, const util::slist &ignore, data::compareMode mode, double tolerance )
 {
 	bool ret = false;
 	util::PropertyMap::DiffMap diff = img1.getDifference( img2 );
@@ -111,10 +111,12 @@ bool diff( const data::Image &img1, const data::Image &img2, const util::slist &
 				<< img1.getSizeAsString() << "/" << img2.getSizeAsString() << std::endl;
 		ret = true;
 	} else {
-		size_t voxels = img1.compare( img2 );
+		const data::CompareResult voxels = img1.compare( img2, mode, tolerance );
 
-		if ( voxels != 0 ) {
-			std::cout << voxels * 100. / img1.getVolume() << "% of the voxels in " << std::endl << name1 << " and " << std::endl << name2 << " differ" << std::endl;
+		if ( voxels.different != 0 ) {
+			std::cout
+					<< voxels.different * 100. / img1.getVolume() << "% of the voxels in " << std::endl << name1 << " and " << std::endl << name2 << " differ"
+					<< " (first at " << voxels.first << ", maximum difference " << voxels.maxAbsDiff << ", rms " << voxels.rms() << ")" << std::endl;
 			ret = true;
 		}
 	}
@@ -145,6 +147,14 @@ int main( int argc, char *argv[] )
 	app.parameters["selectwith"].needed() = false;
 	app.parameters["selectwith"].setDescription( "List of properties which should be used to select images for comparison" );
 
+	app.parameters["tolerance"] = 0.;
+	app.parameters["tolerance"].needed() = false;
+	app.parameters["tolerance"].setDescription( "Voxels which differ by no more than this are regarded equal" );
+
+	app.parameters["relative"] = false;
+	app.parameters["relative"].needed() = false;
+	app.parameters["relative"].setDescription( "Take the tolerance relative to the bigger magnitude of both voxels instead of absolute" );
+
 	app.addLogging<DiffLog>( "" );
 	app.addLogging<DiffDebug>( "" );
 
@@ -176,6 +186,8 @@ int main( int argc, char *argv[] )
 	util::slist ignore = app.parameters["ignore"];
 	ignore.push_back( "source" );
 	boost::shared_ptr<util::ConsoleFeedback> feedback( new util::ConsoleFeedback );
+	const double tolerance = app.parameters["tolerance"];
+	const data::compareMode mode = tolerance == 0 ? data::compare_exact : ( app.parameters["relative"] ? data::compare_relative : data::compare_absolute );
 
 	if( in1.second >= 0 && in2.second >= 0 ) { // seems like we got numbers
 		app.parameters["in1"] = util::slist( 1, in1.first );
@@ -194,7 +206,7 @@ int main( int argc, char *argv[] )
 
 		LOG( DiffLog, info ) << "Comparing single images " << first.identify() << " and " << second.identify();
 
-		if( diff( first, second, ignore ) )
+		if( diff( first, second, ignore, mode, tolerance ) )
 			ret = 1;
 
 	} else if( in1.second <= 0 && in2.second <= 0 ) {
@@ -220,7 +232,7 @@ int main( int argc, char *argv[] )
 					<< ". " << candidates.size() << " where found";
 
 			BOOST_FOREACH( const data::Image & second, candidates ) {
-				if( diff( *first, second, ignore ) )
+				if( diff( *first, second, ignore, mode, tolerance ) )
 					ret++;
 			}
 